@@ -0,0 +1,57 @@
+#ifndef MULTIBASE_ALIGNED_BUFFER_HPP
+#define MULTIBASE_ALIGNED_BUFFER_HPP
+
+#include <algorithm>  // for copy_n
+#include <cstddef>    // for byte, size_t
+#include <memory>     // for unique_ptr
+#include <new>        // for align_val_t
+#include <span>       // for span
+
+namespace multibase {
+
+/// Page aligned block of memory for bulk reads and writes
+class aligned_buffer {
+ public:
+  static constexpr std::size_t alignment = 4096;
+
+  aligned_buffer() = default;
+  explicit aligned_buffer(std::size_t size)
+      : data_{allocate(size)}, size_{size} {}
+
+  [[nodiscard]] std::byte* data() const noexcept { return data_.get(); }
+  [[nodiscard]] std::size_t size() const noexcept { return size_; }
+  [[nodiscard]] std::span<std::byte> span() const noexcept {
+    return {data_.get(), size_};
+  }
+
+  /// Grow to at least size bytes, preserving the first used bytes
+  void reserve(std::size_t size, std::size_t used) {
+    if (size <= size_) {
+      return;
+    }
+    auto grown = allocate(size);
+    std::copy_n(data_.get(), used, grown.get());
+    data_ = std::move(grown);
+    size_ = size;
+  }
+
+ private:
+  struct deleter {
+    void operator()(std::byte* ptr) const noexcept {
+      ::operator delete[](ptr, std::align_val_t{alignment});
+    }
+  };
+  using pointer = std::unique_ptr<std::byte[], deleter>;  // NOLINT
+
+  static pointer allocate(std::size_t size) {
+    return pointer{static_cast<std::byte*>(
+        ::operator new[](size, std::align_val_t{alignment}))};
+  }
+
+  pointer data_;
+  std::size_t size_{0};
+};
+
+}  // namespace multibase
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef MULTIBASE_AVX512_KERNELS_HPP
+#define MULTIBASE_AVX512_KERNELS_HPP
+
+#include <cstddef>      // for byte
+#include <span>         // for span
+#include <string_view>  // for string_view
+
+#include <multibase/encoding.hpp>     // for encoding
+#include <multibase/portability.hpp>  // for MULTIBASE_HAVE_AVX512_KERNELS
+
+#if MULTIBASE_HAVE_AVX512_KERNELS
+/** Base64 and base32 kernels using AVX-512 VBMI, which convert 64 characters
+ at a time and leave the remainder to basic_algorithm. Only call them when
+ detected_isa() is isa::avx512. */
+namespace multibase::avx512 {
+
+template <encoding T>
+std::string_view encode(std::span<const std::byte> input,
+                        std::span<char> output);
+
+template <encoding T>
+std::span<std::byte> decode(std::string_view input,
+                            std::span<std::byte> output);
+
+}  // namespace multibase::avx512
+#endif
+
+#endif
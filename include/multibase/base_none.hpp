@@ -7,6 +7,10 @@
 #include <span>
 #include <string_view>
 
+#include <multibase/encoding.hpp>
+#include <multibase/instrumentation.hpp>
+#include <multibase/validation.hpp>
+
 namespace multibase {
 
 class base_none {
@@ -15,9 +19,11 @@ class base_none {
 
   static std::string_view encode(std::span<const std::byte> input,
                                  std::span<char> output) {
+    auto measured = instrumentation::call{
+        encoding::base_none, instrumentation::operation::encode, input.size()};
     std::ranges::transform(input, output.begin(),
                            [](auto byte) { return static_cast<char>(byte); });
-    return std::string_view{output.data(), input.size()};
+    return measured.finish(std::string_view{output.data(), input.size()});
   }
 
   static char encode(std::byte byte) { return static_cast<char>(byte); }
@@ -26,14 +32,20 @@ class base_none {
 
   static std::span<std::byte> decode(std::string_view input,
                                      std::span<std::byte> output) {
+    auto measured = instrumentation::call{
+        encoding::base_none, instrumentation::operation::decode, input.size()};
     std::ranges::transform(input, output.begin(), [](auto chr) {
       return static_cast<std::byte>(chr);
     });
-    return std::span{output.data(), input.size()};
+    return measured.finish(std::span{output.data(), input.size()});
   }
 
   static std::byte decode(char chr) { return static_cast<std::byte>(chr); }
 
+  static validation_result validate(std::string_view input) noexcept {
+    return {input.size(), std::nullopt};
+  }
+
   static std::optional<std::size_t> encoded_chunk_size() {
     return std::numeric_limits<std::size_t>::max();
   }
@@ -3,10 +3,10 @@
 
 #include <algorithm>    // for min, copy, fill
 #include <array>        // for array
-#include <cctype>       // for tolower, toupper
-#include <cmath>        // for log, ceil
+#include <cmath>        // for log, ceil, floor
 #include <cstddef>      // for size_t
 #include <cstdint>      // for int64_t
+#include <exception>    // for exception
 #include <iterator>     // for size, begin, distance, outp...
 #include <limits>       // for numeric_limits
 #include <memory>       // for to_address
@@ -22,10 +22,12 @@
 #include <range/v3/range/concepts.hpp>  // for sized_range
 #include <range/v3/view/reverse.hpp>    // for reverse_view
 
-#include "multibase/encoding_case.hpp"    // for encoding_case
+#include "multibase/decode_table.hpp"     // for make_decode_table
 #include "multibase/encoding_traits.hpp"  // for encoding_traits
+#include "multibase/instrumentation.hpp"  // for call
 #include "multibase/log.hpp"              // for log2
 #include "multibase/portability.hpp"      // for MULTIBASE_CONSTEVAL
+#include "multibase/validation.hpp"       // for validation_result
 
 namespace multibase {
 
@@ -54,21 +56,30 @@ class basic_algorithm {
                                      std::span<std::byte> output);
   static constexpr std::optional<std::size_t> decoded_chunk_size();
 
+  /** Check that a chunk is well-formed without decoding it
+  @return decoded size, or offset of the first invalid character */
+  static validation_result validate(std::string_view chunk) noexcept;
+
  private:
   using CharsetT = decltype(Traits::alphabet);
   using value_type = typename CharsetT::value_type;
-  using iterator = typename CharsetT::const_iterator;
 
   MULTIBASE_CONSTEVAL static bool is_chunkable();
 
   template <std::ranges::input_range range>
   static std::size_t count_leading_zeros(const range& chunk);
 
-  constexpr static iterator find(const value_type& val) noexcept;
+  /** Bytes of the number written by digits without leading zeros, found from
+  its leading digits, or by decoding it when it lies too close to a power of
+  256 to tell */
+  static std::size_t significant_size(std::string_view digits) noexcept;
 
-  /** Determine the character encoding for a given value
-  @return character encoding, or 0 if none such encoding exists */
-  constexpr static unsigned char getval(char val) noexcept;
+  /** Linear time encoding for a radix which is a power of two, regrouping
+  the input bits rather than converting the whole input as one number */
+  static std::string_view encode_bits(std::span<const std::byte> chunk,
+                                      std::span<char> output);
+  static std::span<std::byte> decode_bits(std::string_view chunk,
+                                          std::span<std::byte> output);
 
   /** encoding as determined by size of character set */
   constexpr static auto radix =
@@ -78,39 +89,12 @@ class basic_algorithm {
   constexpr static auto encoded_chunk_size_ = ratio.num;
   constexpr static auto decoded_chunk_size_ = ratio.den;
   constexpr static auto byte_max = 256;
-  constexpr static auto invalid_value =
-      std::numeric_limits<unsigned char>::max();
   constexpr static auto log256 = 5.545177444479562;
 
-  /** Map from value to corresponding character in base encoding */
-  constexpr static std::array<unsigned char,
-                              std::numeric_limits<char>::max() + 1>
-      valset{getval(0),   getval(1),   getval(2),   getval(3),   getval(4),
-             getval(5),   getval(6),   getval(7),   getval(8),   getval(9),
-             getval(10),  getval(11),  getval(12),  getval(13),  getval(14),
-             getval(15),  getval(16),  getval(17),  getval(18),  getval(19),
-             getval(20),  getval(21),  getval(22),  getval(23),  getval(24),
-             getval(25),  getval(26),  getval(27),  getval(28),  getval(29),
-             getval(30),  getval(31),  getval(32),  getval(33),  getval(34),
-             getval(35),  getval(36),  getval(37),  getval(38),  getval(39),
-             getval(40),  getval(41),  getval(42),  getval(43),  getval(44),
-             getval(45),  getval(46),  getval(47),  getval(48),  getval(49),
-             getval(50),  getval(51),  getval(52),  getval(53),  getval(54),
-             getval(55),  getval(56),  getval(57),  getval(58),  getval(59),
-             getval(60),  getval(61),  getval(62),  getval(63),  getval(64),
-             getval(65),  getval(66),  getval(67),  getval(68),  getval(69),
-             getval(70),  getval(71),  getval(72),  getval(73),  getval(74),
-             getval(75),  getval(76),  getval(77),  getval(78),  getval(79),
-             getval(80),  getval(81),  getval(82),  getval(83),  getval(84),
-             getval(85),  getval(86),  getval(87),  getval(88),  getval(89),
-             getval(90),  getval(91),  getval(92),  getval(93),  getval(94),
-             getval(95),  getval(96),  getval(97),  getval(98),  getval(99),
-             getval(100), getval(101), getval(102), getval(103), getval(104),
-             getval(105), getval(106), getval(107), getval(108), getval(109),
-             getval(110), getval(111), getval(112), getval(113), getval(114),
-             getval(115), getval(116), getval(117), getval(118), getval(119),
-             getval(120), getval(121), getval(122), getval(123), getval(124),
-             getval(125), getval(126), getval(127)};
+  /** Map from character in base encoding to corresponding value */
+  constexpr static decode_table_type valset = make_decode_table<Traits>();
+  /** Characters in base encoding as contiguous ranges */
+  constexpr static alphabet_ranges valranges = make_alphabet_ranges(valset);
 };
 
 template <encoding T, typename Traits>
@@ -133,7 +117,9 @@ std::size_t basic_algorithm<T, Traits>::count_leading_zeros(
     const range& chunk) {
   return static_cast<std::size_t>(std::distance(
       std::begin(chunk),
-      std::ranges::find_if(chunk, [](auto c) { return decode(c) != 0; })));
+      std::ranges::find_if(chunk, [](auto c) {
+        return valset[static_cast<unsigned char>(c)] != 0;
+      })));
 }
 
 template <encoding T, typename Traits>
@@ -182,12 +168,18 @@ std::string_view basic_algorithm<T, Traits>::encode(std::string_view chunk,
 }
 
 /// Real underlying encoding routine which operates on either a chunk or a
-/// full range
+/// full range. Encodings which cannot be chunked are converted as a single
+/// number, which is quadratic in the size of the input.
 /// @param output Buffer in which to write the output. We inevitably need a
 /// buffer so this cannot be an iterator
 template <encoding T, typename Traits>
 std::string_view basic_algorithm<T, Traits>::encode(
     std::span<const std::byte> chunk, std::span<char> output) {
+  auto measured = instrumentation::call{T, instrumentation::operation::encode,
+                                        chunk.size()};
+  if constexpr (is_chunkable()) {
+    return measured.finish(encode_bits(chunk, output));
+  }
   std::ranges::fill(output, static_cast<char>(0));
   auto input_size = std::size(chunk);
   auto partial_blocks =
@@ -195,10 +187,6 @@ std::string_view basic_algorithm<T, Traits>::encode(
   auto unpadded_size = std::min(
       std::size(output), static_cast<std::size_t>(
                              std::ceil(partial_blocks * encoded_chunk_size_)));
-  if constexpr (is_chunkable()) {
-    input_size = static_cast<std::size_t>(std::ceil(partial_blocks) *
-                                          decoded_chunk_size_);
-  }
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wunsafe-buffer-usage"
   auto elem = std::begin(chunk);
@@ -241,19 +229,12 @@ std::string_view basic_algorithm<T, Traits>::encode(
                                              : Traits::padding;
       });
   auto data = output.begin();
-  auto offset = std::size_t{0};
-  if constexpr (!is_chunkable()) {
-    offset = output.size() - std::min(output.size(), len);
-    std::advance(data, offset - std::min(offset, leading_zeroes));
-    len = unpadded_size - offset + leading_zeroes;
-  } else if constexpr (Traits::padding == 0) {
-    len = unpadded_size - offset;
-  } else {
-    len = output.size() - offset;
-  }
+  auto offset = output.size() - std::min(output.size(), len);
+  std::advance(data, offset - std::min(offset, leading_zeroes));
+  len = unpadded_size - offset + leading_zeroes;
   len = std::min(static_cast<std::size_t>(std::distance(data, output.end())),
                  len);
-  return std::string_view{std::to_address(data), len};
+  return measured.finish(std::string_view{std::to_address(data), len});
 }
 
 template <encoding T, typename Traits>
@@ -261,21 +242,7 @@ constexpr std::byte basic_algorithm<T, Traits>::decode(char ch) {
   if (ch == Traits::padding) {
     return std::byte{0};
   }
-  if constexpr (!Traits::is_case_sensitive) {
-    switch (Traits::type_case) {
-      using enum multibase::encoding_case;
-      case lower:
-        ch = static_cast<char>(std::tolower(ch));
-        break;
-      case upper:
-        ch = static_cast<char>(std::toupper(ch));
-        break;
-      case both:
-      case none:
-        break;
-    }
-  }
-  const auto val = valset.at(static_cast<std::size_t>(ch));
+  const auto val = valset[static_cast<unsigned char>(ch)];
   if (val == invalid_value) {
     throw std::invalid_argument{fmt::format("Invalid input character {}", ch)};
   }
@@ -285,6 +252,11 @@ constexpr std::byte basic_algorithm<T, Traits>::decode(char ch) {
 template <encoding T, typename Traits>
 std::span<std::byte> basic_algorithm<T, Traits>::decode(
     std::string_view chunk, std::span<std::byte> output) {
+  auto measured = instrumentation::call{T, instrumentation::operation::decode,
+                                        chunk.size()};
+  if constexpr (is_chunkable()) {
+    return measured.finish(decode_bits(chunk, output));
+  }
   std::ranges::fill(output, static_cast<std::byte>(0));
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wunsafe-buffer-usage"
@@ -294,13 +266,10 @@ std::span<std::byte> basic_algorithm<T, Traits>::decode(
   std::size_t length = 0;
   std::size_t leading_zeroes = 0;
   std::size_t non_zeroes = 0;
-  auto padding = std::size_t{0};
-  auto input_size =
-      is_chunkable() ? encoded_size(output.size()) : std::size(chunk);
+  auto input_size = std::size(chunk);
   for (std::size_t i = 0; i < input_size; ++i) {
     int carry = 0;
     if (first != last) {
-      padding += *first == Traits::padding;
       // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
       carry = static_cast<int>(decode(*first++));
       if (carry != 0) {
@@ -321,16 +290,177 @@ std::span<std::byte> basic_algorithm<T, Traits>::decode(
   }
   auto non_zero = std::ranges::find_if(
       output, [](auto chr) { return static_cast<int>(chr) != 0; });
-  [[maybe_unused]] auto output_size =
-      is_chunkable() ? static_cast<std::size_t>(
-                           static_cast<double>(std::size(chunk) - padding) /
-                           encoded_chunk_size_ * decoded_chunk_size_)
-                     : std::min(length + leading_zeroes, output.size());
+  auto output_size = std::min(length + leading_zeroes, output.size());
   auto offset = static_cast<std::int64_t>(leading_zeroes);
   std::advance(non_zero,
                -1 * std::min(std::distance(output.begin(), non_zero), offset));
-  auto result = std::span{std::to_address(non_zero), output_size};
-  return result;
+  return measured.finish(std::span{std::to_address(non_zero), output_size});
+}
+
+template <encoding T, typename Traits>
+std::string_view basic_algorithm<T, Traits>::encode_bits(
+    std::span<const std::byte> chunk, std::span<char> output) {
+  constexpr auto bits = static_cast<unsigned>(log2(radix));
+  constexpr auto mask = static_cast<unsigned>(radix - 1);
+  constexpr auto byte_bits = 8U;
+  auto digits = (std::size(chunk) * byte_bits + bits - 1) / bits;
+  auto size = digits;
+  if constexpr (Traits::padding != 0) {
+    size = encoded_size(std::size(chunk));
+  }
+  if (std::size(output) < size) {
+    throw std::invalid_argument{
+        fmt::format("Output of {} characters too small to encode {} bytes",
+                    std::size(output), std::size(chunk))};
+  }
+  auto out = output.begin();
+  auto buffer = 0U;
+  auto buffered = 0U;
+  for (auto byte : chunk) {
+    buffer = (buffer << byte_bits) | static_cast<unsigned char>(byte);
+    buffered += byte_bits;
+    while (buffered >= bits) {
+      buffered -= bits;
+      *out++ = Traits::alphabet[(buffer >> buffered) & mask];
+    }
+  }
+  if (buffered > 0) {
+    *out++ = Traits::alphabet[(buffer << (bits - buffered)) & mask];
+  }
+  std::fill(out, std::next(output.begin(), static_cast<std::ptrdiff_t>(size)),
+            Traits::padding);
+  return std::string_view{output.data(), size};
+}
+
+template <encoding T, typename Traits>
+std::span<std::byte> basic_algorithm<T, Traits>::decode_bits(
+    std::string_view chunk, std::span<std::byte> output) {
+  constexpr auto bits = static_cast<unsigned>(log2(radix));
+  constexpr auto byte_bits = 8U;
+  auto size = chunk.size();
+  if constexpr (Traits::padding != 0) {
+    const auto last = chunk.find_last_not_of(Traits::padding);
+    size = last == std::string_view::npos ? 0 : last + 1;
+  }
+  auto out = output.begin();
+  auto buffer = 0U;
+  auto buffered = 0U;
+  // padding before the end is not in the alphabet, so is invalid
+  for (auto chr : chunk.substr(0, size)) {
+    const auto val = valset[static_cast<unsigned char>(chr)];
+    if (val == invalid_value) {
+      throw std::invalid_argument{
+          fmt::format("Invalid input character {}", chr)};
+    }
+    buffer = (buffer << bits) | val;
+    buffered += bits;
+    if (buffered >= byte_bits) {
+      if (out == output.end()) {
+        throw std::invalid_argument{fmt::format(
+            "Output of {} bytes too small to decode {} characters",
+            std::size(output), std::size(chunk))};
+      }
+      buffered -= byte_bits;
+      *out++ = static_cast<std::byte>(buffer >> buffered);
+    }
+  }
+  // as validate, a trailing partial block holds at least one byte, no more
+  // characters than it needs, and no bits beyond those of its bytes
+  const auto remainder = size % encoded_chunk_size_;
+  const auto partial_bytes = remainder * bits / byte_bits;
+  if ((partial_bytes * byte_bits + bits - 1) / bits != remainder) {
+    throw std::invalid_argument{
+        fmt::format("Invalid length of {} characters", size)};
+  }
+  if ((buffer & ((1U << buffered) - 1)) != 0) {
+    throw std::invalid_argument{fmt::format(
+        "Invalid trailing bits in final character {}", chunk[size - 1])};
+  }
+  if constexpr (Traits::padding != 0) {
+    const auto padding = chunk.size() - size;
+    const auto expected =
+        remainder == 0 ? 0 : encoded_chunk_size_ - remainder;
+    if (padding != expected) {
+      throw std::invalid_argument{fmt::format(
+          "Invalid padding of {} characters after {}", padding, size)};
+    }
+  }
+  return std::span{output.data(), static_cast<std::size_t>(
+                                      std::distance(output.begin(), out))};
+}
+
+template <encoding T, typename Traits>
+validation_result basic_algorithm<T, Traits>::validate(
+    std::string_view chunk) noexcept {
+  auto size = chunk.size();
+  if constexpr (Traits::padding != 0) {
+    auto last = chunk.find_last_not_of(Traits::padding);
+    size = last == std::string_view::npos ? 0 : last + 1;
+  }
+  const auto data = chunk.substr(0, size);
+  if (auto offset = find_invalid(data, valranges); offset != size) {
+    return {0, offset};
+  }
+  if constexpr (is_chunkable()) {
+    constexpr auto bits = static_cast<std::size_t>(log2(radix));
+    constexpr auto byte_bits = std::size_t{8};
+    // a trailing partial block must hold at least one byte, and no more
+    // characters than are needed to encode the bytes it holds
+    auto remainder = size % encoded_chunk_size_;
+    auto partial_bytes = remainder * bits / byte_bits;
+    if ((partial_bytes * byte_bits + bits - 1) / bits != remainder) {
+      return {0, size - remainder};
+    }
+    const auto unused = size * bits % byte_bits;
+    if (unused != 0 && (valset[static_cast<unsigned char>(data.back())] &
+                        ((1U << unused) - 1)) != 0) {
+      return {0, size - 1};
+    }
+    if constexpr (Traits::padding != 0) {
+      auto padding = chunk.size() - size;
+      auto expected = remainder == 0 ? 0 : encoded_chunk_size_ - remainder;
+      if (padding != expected) {
+        return {0, size};
+      }
+    }
+    return {size * bits / byte_bits, std::nullopt};
+  } else {
+    const auto zeros = count_leading_zeros(data);
+    return {zeros + significant_size(data.substr(zeros)), std::nullopt};
+  }
+}
+
+template <encoding T, typename Traits>
+std::size_t basic_algorithm<T, Traits>::significant_size(
+    std::string_view digits) noexcept {
+  if (digits.empty()) {
+    return 0;
+  }
+  // few enough that the number they write is exact in a double
+  constexpr auto leading_digits = std::size_t{8};
+  const auto count = std::min(digits.size(), leading_digits);
+  auto leading = 0.0;
+  for (auto chr : digits.substr(0, count)) {
+    leading = leading * radix + valset[static_cast<unsigned char>(chr)];
+  }
+  // the base 256 logarithm of the number lies between low and high, give or
+  // take the rounding of scale
+  const auto scale = static_cast<double>(digits.size() - count) *
+                     std::log(radix) / log256;
+  const auto low = std::log(leading) / log256 + scale;
+  const auto high =
+      count == digits.size() ? low : std::log(leading + 1) / log256 + scale;
+  constexpr auto rounding = 1e-6;
+  const auto least = std::floor(low - rounding);
+  if (least == std::floor(high + rounding)) {
+    return static_cast<std::size_t>(least) + 1;
+  }
+  try {
+    auto output = std::vector<std::byte>(decoded_size(digits.size()));
+    return decode(digits, output).size();
+  } catch (const std::exception&) {
+    return decoded_size(digits.size());
+  }
 }
 
 template <encoding T, typename Traits>
@@ -359,22 +489,6 @@ basic_algorithm<T, Traits>::decoded_chunk_size() {
   return std::nullopt;
 }
 
-template <encoding T, typename Traits>
-constexpr typename basic_algorithm<T, Traits>::iterator
-basic_algorithm<T, Traits>::find(const value_type& val) noexcept {
-  return std::ranges::find(std::cbegin(Traits::alphabet),
-                           std::cend(Traits::alphabet), val);
-}
-
-/** Determine the character encoding for a given value
-  @return character encoding, or 0 if none such encoding exists */
-template <encoding T, typename Traits>
-constexpr unsigned char basic_algorithm<T, Traits>::getval(char val) noexcept {
-  return find(val) == std::cend(Traits::alphabet)
-             ? invalid_value
-             : static_cast<unsigned char>(
-                   std::distance(std::cbegin(Traits::alphabet), find(val)));
-}
 }  // namespace multibase
 
 #endif
@@ -0,0 +1,147 @@
+#ifndef MULTIBASE_CHUNKS_HPP
+#define MULTIBASE_CHUNKS_HPP
+
+#include <algorithm>    // for min
+#include <cstddef>      // for byte, size_t, ptrdiff_t
+#include <optional>     // for optional
+#include <ranges>       // for all, data, size, contiguous_range
+#include <span>         // for span
+#include <stdexcept>    // for invalid_argument
+#include <string_view>  // for string_view
+#include <type_traits>  // for conditional_t
+#include <utility>      // for forward
+#include <vector>       // for vector
+
+#include <multibase/codec.hpp>      // for codec, encode, decode
+#include <multibase/encoding.hpp>   // for encoding
+#include <multibase/generator.hpp>  // for generator
+#include <multibase/views.hpp>      // for direction, append, chunk_sizes
+
+namespace multibase {
+
+/// A piece of input, such as the bytes of a single read
+template <typename T>
+concept chunk = std::ranges::contiguous_range<T> &&
+                std::ranges::sized_range<T> &&
+                sizeof(std::ranges::range_value_t<T>) == 1;
+
+namespace detail {
+
+template <direction D>
+using chunk_output = std::conditional_t<D == direction::encode,
+                                        std::string_view,
+                                        std::span<const std::byte>>;
+
+/// Convert pieces of input as they come, yielding the whole chunks of each
+/// from one buffer and keeping back a partial chunk for the next piece
+template <direction D, std::ranges::input_range Chunks>
+generator<chunk_output<D>> convert_chunks(Chunks chunks,
+                                          std::optional<encoding> base,
+                                          bool multiformat) {
+  auto converter = std::optional<codec>{};
+  auto granule = std::size_t{0};
+  auto carry = std::vector<input_type<D>>{};
+  auto output = std::vector<output_type<D>>{};
+  const auto start = [&] {
+    converter.emplace(*base);
+    if constexpr (D == direction::encode) {
+      if (multiformat) {
+        output.push_back(multibase::encode(*base));
+      }
+    }
+    // an encoding which cannot be chunked is converted whole at the end
+    if (converter->encoded_chunk_size() && converter->decoded_chunk_size()) {
+      granule = chunk_sizes<D>(*converter).first;
+    }
+  };
+  for (const auto& piece : chunks) {
+    auto input =
+        std::span{static_cast<const input_type<D>*>(
+                      static_cast<const void*>(std::ranges::data(piece))),
+                  std::ranges::size(piece)};
+    if (!base) {
+      if (input.empty()) {
+        continue;
+      }
+      base = multibase::decode(static_cast<char>(input.front()));
+      input = input.subspan(1);
+    }
+    if (!converter) {
+      start();
+    }
+    if (granule == 0) {
+      carry.insert(carry.end(), input.begin(), input.end());
+      continue;
+    }
+    if (!carry.empty()) {
+      const auto head = input.first(std::min(granule - carry.size(),
+                                             input.size()));
+      carry.insert(carry.end(), head.begin(), head.end());
+      input = input.subspan(head.size());
+      if (carry.size() < granule) {
+        continue;
+      }
+      append<D>(*converter, carry, output);
+      carry.clear();
+    }
+    const auto whole = input.size() / granule * granule;
+    append<D>(*converter, input.first(whole), output);
+    carry.assign(input.begin() + static_cast<std::ptrdiff_t>(whole),
+                 input.end());
+    if (!output.empty()) {
+      co_yield chunk_output<D>{output.data(), output.size()};
+      output.clear();
+    }
+  }
+  if (!base) {
+    throw std::invalid_argument{"Missing multibase prefix"};
+  }
+  if (!converter) {
+    start();
+  }
+  append<D>(*converter, carry, output);
+  if (!output.empty()) {
+    co_yield chunk_output<D>{output.data(), output.size()};
+  }
+}
+
+}  // namespace detail
+
+/** Encode a range of pieces of input, such as successive reads, yielding the
+ encoding of the whole chunks of each piece as it comes and then the rest.
+ Each piece yielded is only valid until the next is asked for. An encoding
+ which cannot be chunked is yielded whole once the input ends. */
+template <std::ranges::viewable_range R>
+  requires std::ranges::input_range<R> &&
+           chunk<std::ranges::range_reference_t<R>>
+generator<std::string_view> encode_chunks(R&& source, encoding base,
+                                          bool multiformat = true) {
+  return detail::convert_chunks<detail::direction::encode>(
+      std::views::all(std::forward<R>(source)), base, multiformat);
+}
+
+/// Decode a range of pieces of an encoding which starts with its multibase
+/// prefix, as encode_chunks encodes them
+/// @throw std::invalid_argument, as the pieces are decoded, for an invalid
+/// or missing prefix or character
+template <std::ranges::viewable_range R>
+  requires std::ranges::input_range<R> &&
+           chunk<std::ranges::range_reference_t<R>>
+generator<std::span<const std::byte>> decode_chunks(R&& source) {
+  return detail::convert_chunks<detail::direction::decode>(
+      std::views::all(std::forward<R>(source)), std::nullopt, false);
+}
+
+/// Decode a range of pieces of an encoding without a multibase prefix
+template <std::ranges::viewable_range R>
+  requires std::ranges::input_range<R> &&
+           chunk<std::ranges::range_reference_t<R>>
+generator<std::span<const std::byte>> decode_chunks(R&& source,
+                                                    encoding base) {
+  return detail::convert_chunks<detail::direction::decode>(
+      std::views::all(std::forward<R>(source)), base, false);
+}
+
+}  // namespace multibase
+
+#endif
@@ -15,7 +15,9 @@
 
 #include <multibase/base_none.hpp>
 #include <multibase/basic_algorithm.hpp>  // for basic_algorithm
+#include <multibase/dispatch.hpp>         // for select_kernel
 #include <multibase/encoding.hpp>         // for encoding, encoding::base_10
+#include <multibase/validation.hpp>       // for validation_result
 
 namespace multibase {
 
@@ -40,6 +42,7 @@ class codec {
                               std::span<std::byte> output);
   [[nodiscard]] std::optional<std::size_t> encoded_chunk_size() const;
   [[nodiscard]] std::optional<std::size_t> decoded_chunk_size() const;
+  validation_result validate(std::string_view input);
 
  private:
   std::size_t (*encoded_size_)(std::size_t len){nullptr};
@@ -52,9 +55,10 @@ class codec {
   std::byte (*decode_byte_)(char chr){nullptr};
   std::optional<std::size_t> (*encoded_chunk_size_)(){nullptr};
   std::optional<std::size_t> (*decoded_chunk_size_)(){nullptr};
+  validation_result (*validate_)(std::string_view){nullptr};
 
   template <typename impl>
-  constexpr void init();
+  void init();
 
   template <std::ranges::input_range range>
   std::size_t count_leading_zeros(const range& chunk);
@@ -98,6 +102,11 @@ template <std::ranges::input_range range,
           std::output_iterator<std::byte> OutputIt>
 OutputIt decode(const range& input, OutputIt output, encoding base);
 
+/// Check that input is a well-formed multibase string without decoding it.
+/// @param base If set, the encoding which the multibase prefix must name
+validation_result validate(std::string_view input,
+                           std::optional<encoding> base = std::nullopt);
+
 using base_none = base_none;
 using base_2 = basic_algorithm<encoding::base_2>;
 using base_8 = basic_algorithm<encoding::base_8>;
@@ -171,6 +180,12 @@ OutputIt encode(const range& input, OutputIt output, encoding base,
   if (multiformat) {
     *output++ = encode(base);
   }
+  if (base == encoding::base_none) {
+    // every byte is its own character, so there is no chunk to gather
+    return std::ranges::transform(input, output, [](auto value) {
+             return static_cast<char>(value);
+           }).out;
+  }
   auto chunk_output = std::vector<char>(*encoded_chunk_size);
   auto chunk_input = std::vector<std::byte>(*decoded_chunk_size);
   auto first = std::begin(input);
@@ -244,6 +259,11 @@ OutputIt decode(const range& input, OutputIt output, encoding base) {
         decoder.decode(input_buffer, output_buffer);
     return std::ranges::copy(output_span, output).out;
   }
+  if (base == encoding::base_none) {
+    return std::ranges::transform(input, output, [](auto value) {
+             return static_cast<std::byte>(value);
+           }).out;
+  }
   auto chunk_output = std::vector<std::byte>(*decoded_chunk_size);
   auto chunk_input = std::vector<char>(*encoded_chunk_size);
   auto first = std::begin(input);
@@ -270,7 +290,7 @@ OutputIt decode(const range& input, OutputIt output, encoding base) {
 }
 
 template <typename impl>
-constexpr void codec::init() {
+void codec::init() {
   encoded_size_ = &impl::encoded_size;
   encode_ = &impl::encode;
   encode_byte_ = &impl::encode;
@@ -279,6 +299,17 @@ constexpr void codec::init() {
   decode_ = &impl::decode;
   decode_byte_ = &impl::decode;
   decoded_chunk_size_ = &impl::decoded_chunk_size;
+  validate_ = &impl::validate;
+  if constexpr (requires { impl::encoding; }) {
+    if (const auto* selected = select_kernel(impl::encoding)) {
+      if (selected->encode != nullptr) {
+        encode_ = selected->encode;
+      }
+      if (selected->decode != nullptr) {
+        decode_ = selected->decode;
+      }
+    }
+  }
 }
 
 template <std::ranges::input_range range>
@@ -0,0 +1,82 @@
+#ifndef MULTIBASE_DECODE_TABLE_HPP
+#define MULTIBASE_DECODE_TABLE_HPP
+
+#include <array>    // for array
+#include <cstddef>  // for size_t
+#include <limits>   // for numeric_limits
+
+#include "multibase/encoding.hpp"         // for encoding
+#include "multibase/encoding_case.hpp"    // for encoding_case
+#include "multibase/encoding_traits.hpp"  // for encoding_traits
+
+namespace multibase {
+
+/** Value of a character which is not part of an alphabet */
+constexpr unsigned char invalid_value =
+    std::numeric_limits<unsigned char>::max();
+
+/** Map from every possible character to its value in an alphabet */
+using decode_table_type =
+    std::array<unsigned char, std::numeric_limits<unsigned char>::max() + 1>;
+
+namespace detail {
+
+constexpr unsigned char to_lower(unsigned char chr) noexcept {
+  return chr >= 'A' && chr <= 'Z' ? static_cast<unsigned char>(chr - 'A' + 'a')
+                                  : chr;
+}
+
+constexpr unsigned char to_upper(unsigned char chr) noexcept {
+  return chr >= 'a' && chr <= 'z' ? static_cast<unsigned char>(chr - 'a' + 'A')
+                                  : chr;
+}
+
+}  // namespace detail
+
+/** Generate the decode table of an encoding from its traits.
+ Characters of case-insensitive encodings are folded to the case of the
+ alphabet, without reference to the locale.
+ @return table indexed by unsigned character, holding invalid_value for
+ characters outside the alphabet */
+template <typename Traits>
+constexpr decode_table_type make_decode_table() noexcept {
+  auto direct = decode_table_type{};
+  direct.fill(invalid_value);
+  for (std::size_t i = 0; i < Traits::alphabet.size(); ++i) {
+    auto& val = direct.at(static_cast<unsigned char>(Traits::alphabet.at(i)));
+    if (val == invalid_value) {
+      val = static_cast<unsigned char>(i);
+    }
+  }
+  if constexpr (Traits::is_case_sensitive) {
+    return direct;
+  } else {
+    auto folded = decode_table_type{};
+    for (std::size_t i = 0; i < folded.size(); ++i) {
+      auto chr = static_cast<unsigned char>(i);
+      switch (Traits::type_case) {
+        using enum multibase::encoding_case;
+        case lower:
+          chr = detail::to_lower(chr);
+          break;
+        case upper:
+          chr = detail::to_upper(chr);
+          break;
+        case both:
+        case none:
+          break;
+      }
+      folded.at(i) = direct.at(chr);
+    }
+    return folded;
+  }
+}
+
+/** Decode table for each encoding, shared by all decode kernels */
+template <encoding T>
+constexpr decode_table_type decode_table =
+    make_decode_table<encoding_traits<T>>();
+
+}  // namespace multibase
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef MULTIBASE_DISPATCH_HPP
+#define MULTIBASE_DISPATCH_HPP
+
+#include <cstddef>      // for byte, size_t
+#include <span>         // for span
+#include <string_view>  // for string_view
+
+#include <multibase/encoding.hpp>  // for encoding
+
+namespace multibase {
+
+/// Instruction set levels for which kernels may be compiled, in increasing
+/// order. Each implies the ones before it.
+enum class isa {
+  /// The portable implementation alone
+  scalar,
+  /// Portable kernels working on 64 bit words, available everywhere
+  swar,
+  /// SSE4.1 and SSSE3
+  sse4,
+  /// AVX2 and BMI2
+  avx2,
+  /// AVX-512 F, BW, VL and VBMI
+  avx512
+};
+
+/// Highest level the processor and operating system support, found with
+/// CPUID on first use
+isa detected_isa() noexcept;
+
+/// Level for which codecs select kernels: the detected level, lowered by
+/// the MULTIBASE_ISA environment variable (scalar, swar, sse4, avx2 or
+/// avx512) or by set_isa
+isa active_isa() noexcept;
+
+/// Select kernels for level in codecs constructed from now on, capped at the
+/// detected level
+/// @return the level now active
+isa set_isa(isa level) noexcept;
+
+/// Implementation of an encoding for one instruction set level. Either
+/// function may be null to keep the portable one for that direction.
+struct kernel {
+  encoding base;
+  isa level;
+  std::string_view name;
+  std::string_view (*encode)(std::span<const std::byte>, std::span<char>);
+  std::span<std::byte> (*decode)(std::string_view, std::span<std::byte>);
+};
+
+/// Kernel of the highest level no greater than the active one, or null when
+/// the portable implementation is used
+const kernel* select_kernel(encoding base) noexcept;
+
+/// Kernel of the highest level no greater than limit, or null
+const kernel* select_kernel(encoding base, isa limit) noexcept;
+
+/// Name of the kernels codecs of base now use, "scalar" for the portable
+/// implementation
+std::string_view active_kernel(encoding base) noexcept;
+
+/// How kernels write their output
+enum class store_mode {
+  /// Stream outputs of at least streaming_threshold() bytes, cache others
+  automatic,
+  /// Ordinary stores, which keep the output in cache
+  cached,
+  /// Non-temporal stores, which write around the cache, with the input
+  /// prefetched ahead of use. Only the AVX-512 kernels stream.
+  streaming
+};
+
+/// Store mode of kernels called on this thread, automatic unless set
+store_mode active_store_mode() noexcept;
+
+/// Set the store mode of kernels called on this thread, such as for a single
+/// large call
+/// @return the mode previously active
+store_mode set_store_mode(store_mode mode) noexcept;
+
+/// Output size in bytes from which automatic mode streams: half the last
+/// level cache, or the MULTIBASE_STREAMING_THRESHOLD environment variable
+std::size_t streaming_threshold() noexcept;
+
+/// Set the streaming threshold of every thread
+void set_streaming_threshold(std::size_t bytes) noexcept;
+
+/// Whether a kernel writing size bytes of output streams in the active mode
+bool streams(std::size_t size) noexcept;
+
+}  // namespace multibase
+
+#endif
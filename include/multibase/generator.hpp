@@ -0,0 +1,127 @@
+#ifndef MULTIBASE_GENERATOR_HPP
+#define MULTIBASE_GENERATOR_HPP
+
+#include <coroutine>  // for coroutine_handle, suspend_always
+#include <cstddef>    // for ptrdiff_t
+#include <exception>  // for exception_ptr, current_exception
+#include <iterator>   // for default_sentinel_t, input_iterator_tag
+#include <memory>     // for addressof
+#include <ranges>     // for view_interface
+#include <utility>    // for exchange
+
+namespace multibase {
+
+/** Coroutine yielding a sequence of values, as a single pass view, until
+ std::generator is available. A value yielded is only valid until the
+ coroutine is resumed, and an exception thrown by the coroutine is rethrown
+ by the iterator which resumed it. */
+template <typename T>
+class generator : public std::ranges::view_interface<generator<T>> {
+ public:
+  class promise_type;
+
+ private:
+  using handle = std::coroutine_handle<promise_type>;
+
+ public:
+  class promise_type {
+   public:
+    generator get_return_object() noexcept {
+      return generator{handle::from_promise(*this)};
+    }
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+
+    std::suspend_always final_suspend() const noexcept { return {}; }
+
+    std::suspend_always yield_value(const T& yielded) noexcept {
+      value = std::addressof(yielded);
+      return {};
+    }
+
+    void return_void() const noexcept {}
+
+    void unhandled_exception() noexcept {
+      exception = std::current_exception();
+    }
+
+    /// Values are only produced, so nothing is awaited
+    template <typename U>
+    void await_transform(U&&) = delete;
+
+    const T* value{nullptr};
+    std::exception_ptr exception;
+  };
+
+  class iterator {
+   public:
+    using iterator_concept = std::input_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+
+    iterator() = default;
+    explicit iterator(handle coroutine) : coroutine_{coroutine} {}
+
+    const T& operator*() const { return *coroutine_.promise().value; }
+
+    iterator& operator++() {
+      resume(coroutine_);
+      return *this;
+    }
+
+    void operator++(int) { ++*this; }
+
+    bool operator==(std::default_sentinel_t /*end*/) const {
+      return coroutine_.done();
+    }
+
+   private:
+    handle coroutine_;
+  };
+
+  generator(generator&& other) noexcept
+      : coroutine_{std::exchange(other.coroutine_, {})} {}
+
+  generator& operator=(generator&& other) noexcept {
+    if (this != &other) {
+      destroy();
+      coroutine_ = std::exchange(other.coroutine_, {});
+    }
+    return *this;
+  }
+
+  generator(const generator&) = delete;
+  generator& operator=(const generator&) = delete;
+
+  ~generator() { destroy(); }
+
+  iterator begin() {
+    resume(coroutine_);
+    return iterator{coroutine_};
+  }
+
+  [[nodiscard]] std::default_sentinel_t end() const noexcept { return {}; }
+
+ private:
+  explicit generator(handle coroutine) : coroutine_{coroutine} {}
+
+  /// Run the coroutine to its next value, rethrowing what it threw
+  static void resume(handle coroutine) {
+    coroutine.resume();
+    if (auto exception = std::exchange(coroutine.promise().exception, {})) {
+      std::rethrow_exception(exception);
+    }
+  }
+
+  void destroy() noexcept {
+    if (coroutine_) {
+      coroutine_.destroy();
+    }
+  }
+
+  handle coroutine_;
+};
+
+}  // namespace multibase
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef MULTIBASE_INPUT_SOURCE_HPP
+#define MULTIBASE_INPUT_SOURCE_HPP
+
+#include <cstddef>   // for byte, size_t
+#include <optional>  // for optional
+#include <span>      // for span
+#include <string>    // for string
+#include <vector>    // for vector
+
+#include <multibase/aligned_buffer.hpp>  // for aligned_buffer
+
+namespace multibase {
+
+class output_sink;
+
+/// Input of the command line tool, presented as spans of bytes.
+/// Regular files are memory mapped and delivered as a single span, anything
+/// else is read in large blocks into an aligned buffer.
+class input_source {
+ public:
+  /// Size of the blocks in which unmapped input is read
+  static constexpr std::size_t block_size = std::size_t{1} << 20U;
+
+  /// Read standard input
+  input_source();
+  /// Read the named file
+  explicit input_source(const std::string& filename);
+  input_source(const input_source&) = delete;
+  input_source(input_source&& other) noexcept;
+  input_source& operator=(const input_source&) = delete;
+  input_source& operator=(input_source&& other) noexcept;
+  ~input_source();
+
+  /// Next span of input, valid until the following call.
+  /// @return empty span at the end of the input
+  std::span<const std::byte> next();
+
+  /// All remaining input, valid for the lifetime of the source
+  std::span<const std::byte> read_all();
+
+  /// Copy all remaining input to the sink, bypassing user space where the
+  /// platform allows it
+  void transfer_to(output_sink& sink);
+
+  /// Size of the remaining input, if known without reading it
+  [[nodiscard]] std::optional<std::size_t> size() const noexcept;
+
+  [[nodiscard]] bool is_mapped() const noexcept { return map_ != nullptr; }
+
+  /// Number of bytes delivered or transferred so far
+  [[nodiscard]] std::size_t consumed() const noexcept { return consumed_; }
+
+ private:
+  void init();
+  void release() noexcept;
+  std::size_t read_some(std::span<std::byte> buffer);
+
+  int fd_{-1};
+  bool owns_fd_{false};
+  std::byte* map_{nullptr};
+  std::size_t map_size_{0};
+  std::size_t position_{0};
+  std::size_t consumed_{0};
+  aligned_buffer buffer_;
+  std::vector<std::byte> contents_;
+};
+
+}  // namespace multibase
+
+#endif
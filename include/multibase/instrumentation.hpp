@@ -0,0 +1,124 @@
+#ifndef MULTIBASE_INSTRUMENTATION_HPP
+#define MULTIBASE_INSTRUMENTATION_HPP
+
+#include <array>    // for array
+#include <chrono>   // for steady_clock, nanoseconds
+#include <cstddef>  // for size_t
+#include <cstdint>  // for uint64_t
+
+#include <magic_enum.hpp>  // for enum_count
+
+#include <multibase/encoding.hpp>     // for encoding
+#include <multibase/portability.hpp>  // for MULTIBASE_INSTRUMENTATION
+
+/** Counters of the calls to encode and decode for each encoding, compiled in
+ when MULTIBASE_INSTRUMENTATION is set. Each thread updates counters of its
+ own with relaxed stores, which are only added together when read. */
+namespace multibase::instrumentation {
+
+inline constexpr bool enabled = MULTIBASE_INSTRUMENTATION != 0;
+
+/// Whether calls are also counted by input size
+inline constexpr bool histogram = MULTIBASE_INSTRUMENTATION_HISTOGRAM != 0;
+
+enum class operation { encode, decode };
+
+/// Bucket 0 counts empty inputs and bucket i inputs of 2^(i-1) up to 2^i
+/// bytes, the last holding everything larger
+inline constexpr std::size_t size_buckets = 32;
+
+struct statistics {
+  std::uint64_t calls{0};
+  std::uint64_t bytes_in{0};
+  std::uint64_t bytes_out{0};
+  /// Calls which threw
+  std::uint64_t errors{0};
+  std::chrono::nanoseconds elapsed{0};
+  /// Calls by input size, when the histogram is enabled
+  std::array<std::uint64_t, size_buckets> sizes{};
+};
+
+/// Counters of every thread at one time
+class snapshot {
+ public:
+  [[nodiscard]] const statistics& operator()(encoding base,
+                                             operation op) const;
+  statistics& operator()(encoding base, operation op);
+
+ private:
+  static constexpr auto encodings = magic_enum::enum_count<encoding>();
+  std::array<statistics, 2 * encodings> statistics_{};
+};
+
+/// Totals of every thread, including those which have exited. Without
+/// instrumentation all are zero.
+snapshot read();
+
+#if MULTIBASE_INSTRUMENTATION
+namespace detail {
+/// Whether the thread is inside a call already, as when a kernel hands its
+/// tail to the portable implementation
+inline thread_local bool in_call = false;
+}  // namespace detail
+
+/// Time one call, recording it when finished or as an error if it throws.
+/// Calls made within it are not recorded separately.
+class call {
+ public:
+  call(encoding base, operation op, std::size_t bytes_in) noexcept
+      : base_{base},
+        op_{op},
+        outermost_{!detail::in_call},
+        bytes_in_{bytes_in},
+        start_{std::chrono::steady_clock::now()} {
+    detail::in_call = true;
+  }
+  call(const call&) = delete;
+  call(call&&) = delete;
+  call& operator=(const call&) = delete;
+  call& operator=(call&&) = delete;
+  ~call() {
+    if (outermost_) {
+      detail::in_call = false;
+      if (!finished_) {
+        record(0, true);
+      }
+    }
+  }
+
+  /// Record the call producing result
+  template <typename result_type>
+  result_type finish(result_type result) noexcept {
+    if (outermost_ && !finished_) {
+      finished_ = true;
+      record(result.size(), false);
+    }
+    return result;
+  }
+
+ private:
+  void record(std::size_t bytes_out, bool failed) const noexcept;
+
+  encoding base_;
+  operation op_;
+  bool outermost_;
+  bool finished_{false};
+  std::size_t bytes_in_;
+  std::chrono::steady_clock::time_point start_;
+};
+#else
+class call {
+ public:
+  constexpr call(encoding /*base*/, operation /*op*/,
+                 std::size_t /*bytes_in*/) noexcept {}
+
+  template <typename result_type>
+  constexpr result_type finish(result_type result) noexcept {
+    return result;
+  }
+};
+#endif
+
+}  // namespace multibase::instrumentation
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef MULTIBASE_ORDERED_POOL_HPP
+#define MULTIBASE_ORDERED_POOL_HPP
+
+#include <algorithm>           // for max, min
+#include <condition_variable>  // for condition_variable
+#include <cstddef>             // for size_t
+#include <exception>           // for exception_ptr, current_exception
+#include <mutex>               // for mutex, unique_lock, lock_guard
+#include <optional>            // for optional
+#include <thread>              // for jthread
+#include <type_traits>         // for invoke_result_t
+#include <utility>             // for move
+#include <vector>              // for vector
+
+namespace multibase {
+
+/** Produce results for the indices [0, count) on a pool of threads and
+ consume them on the calling thread in index order.
+ At most window results are held at once: a thread may not start on an index
+ until every index a window before it has been consumed. The first exception
+ thrown by produce or consume stops the pool and is rethrown.
+ @param jobs Number of threads producing results
+ @param window Number of results which may be waiting to be consumed */
+template <typename Produce, typename Consume>
+void for_each_ordered(std::size_t count, std::size_t jobs, std::size_t window,
+                      Produce produce, Consume consume) {
+  using result_type = std::invoke_result_t<Produce&, std::size_t>;
+  struct slot {
+    std::optional<result_type> result;
+    std::exception_ptr error;
+    bool is_ready{false};
+  };
+
+  window = std::max<std::size_t>(window, 1);
+  auto slots = std::vector<slot>(window);
+  auto mutex = std::mutex{};
+  auto produced = std::condition_variable{};
+  auto consumed = std::condition_variable{};
+  auto claimed = std::size_t{0};
+  auto delivered = std::size_t{0};
+  auto is_cancelled = false;
+
+  auto worker = [&]() {
+    for (;;) {
+      auto index = std::size_t{0};
+      {
+        auto lock = std::unique_lock{mutex};
+        consumed.wait(lock, [&]() {
+          return is_cancelled || claimed >= count ||
+                 claimed < delivered + window;
+        });
+        if (is_cancelled || claimed >= count) {
+          return;
+        }
+        index = claimed++;
+      }
+      auto done = slot{};
+      try {
+        done.result.emplace(produce(index));
+      } catch (...) {
+        done.error = std::current_exception();
+      }
+      done.is_ready = true;
+      {
+        auto lock = std::lock_guard{mutex};
+        slots[index % window] = std::move(done);
+      }
+      produced.notify_one();
+    }
+  };
+
+  // threads are joined before the state they share goes out of scope
+  auto threads = std::vector<std::jthread>{};
+  threads.reserve(std::min(jobs, count));
+  try {
+    for (std::size_t i = 0; i < std::min(jobs, count); ++i) {
+      threads.emplace_back(worker);
+    }
+    while (delivered < count) {
+      auto next = slot{};
+      {
+        auto lock = std::unique_lock{mutex};
+        auto& current = slots[delivered % window];
+        produced.wait(lock, [&current]() { return current.is_ready; });
+        next = std::move(current);
+        current = slot{};
+      }
+      if (next.error) {
+        std::rethrow_exception(next.error);
+      }
+      consume(*next.result);
+      {
+        auto lock = std::lock_guard{mutex};
+        ++delivered;
+      }
+      consumed.notify_all();
+    }
+  } catch (...) {
+    {
+      auto lock = std::lock_guard{mutex};
+      is_cancelled = true;
+    }
+    consumed.notify_all();
+    throw;
+  }
+}
+
+}  // namespace multibase
+
+#endif
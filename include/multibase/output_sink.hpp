@@ -0,0 +1,96 @@
+#ifndef MULTIBASE_OUTPUT_SINK_HPP
+#define MULTIBASE_OUTPUT_SINK_HPP
+
+#include <cstddef>      // for byte, size_t
+#include <optional>     // for optional
+#include <span>         // for span
+#include <string>       // for string
+#include <string_view>  // for string_view
+
+#include <multibase/aligned_buffer.hpp>  // for aligned_buffer
+
+namespace multibase {
+
+/// Output of the command line tool, gathered into large blocks which are
+/// written to a file descriptor with a single system call each. Output files
+/// of known size are instead mapped into memory and written in place.
+class output_sink {
+ public:
+  /// Tag selecting a sink which keeps all of its output in memory
+  struct in_memory_t {
+    explicit in_memory_t() = default;
+  };
+  static constexpr in_memory_t in_memory{};
+
+  /// Size of the blocks in which output is written
+  static constexpr std::size_t block_size = std::size_t{1} << 20U;
+
+  /// Write to standard output
+  output_sink();
+  /// Write to an open file descriptor, which remains owned by the caller
+  explicit output_sink(int descriptor);
+  /// Replace the named file, which is removed again if the sink is destroyed
+  /// by an exception before it is closed
+  /// @param size Expected size of the output, which may be an overestimate.
+  /// If set, the file is preallocated and mapped into memory.
+  output_sink(const std::string& filename, std::optional<std::size_t> size);
+  /// Gather all output in memory, to be read back with contents()
+  explicit output_sink(in_memory_t /*tag*/);
+  output_sink(const output_sink&) = delete;
+  output_sink(output_sink&&) = delete;
+  output_sink& operator=(const output_sink&) = delete;
+  output_sink& operator=(output_sink&&) = delete;
+  ~output_sink();
+
+  /// Space for at least size characters, valid until the next call
+  std::span<char> prepare(std::size_t size);
+  /// Mark the first size characters of the prepared space as written
+  void commit(std::size_t size) noexcept;
+
+  void write(std::string_view chars);
+  void write(std::span<const std::byte> bytes);
+
+  /// Count size bytes which were written to the descriptor directly, after
+  /// a flush
+  void note_written(std::size_t size) noexcept { written_ += size; }
+
+  /// Write out everything buffered so far
+  void flush();
+
+  /// Flush, and for a mapped file truncate it to the size written
+  void close();
+
+  /// Drop the output after a failure: anything buffered is lost, and a file
+  /// the sink created is removed rather than left holding part of it
+  void discard() noexcept;
+
+  /// Output gathered by an in memory sink
+  [[nodiscard]] std::span<const std::byte> contents() const noexcept {
+    return buffer_.span().first(used_);
+  }
+
+  /// Descriptor written to, or negative for an in memory sink
+  [[nodiscard]] int descriptor() const noexcept { return fd_; }
+  [[nodiscard]] bool is_mapped() const noexcept { return map_ != nullptr; }
+
+  /// Number of bytes written to the sink so far
+  [[nodiscard]] std::size_t written() const noexcept { return written_; }
+
+ private:
+  void map(std::size_t size);
+  void unmap() noexcept;
+
+  int fd_;
+  bool owns_fd_{false};
+  std::string filename_;
+  int exceptions_{0};
+  aligned_buffer buffer_;
+  std::size_t used_{0};
+  std::byte* map_{nullptr};
+  std::size_t map_size_{0};
+  std::size_t written_{0};
+};
+
+}  // namespace multibase
+
+#endif
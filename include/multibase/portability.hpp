@@ -22,4 +22,47 @@
 #endif
 #endif
 
+// SSE2 is part of the x86-64 baseline
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MULTIBASE_HAVE_SSE2 1
+#else
+#define MULTIBASE_HAVE_SSE2 0
+#endif
+
+// AVX-512 VBMI kernels, compiled for their own target on x86-64 so that
+// the rest of the library keeps the baseline instruction set
+#ifndef MULTIBASE_HAVE_AVX512_KERNELS
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define MULTIBASE_HAVE_AVX512_KERNELS 1
+#else
+#define MULTIBASE_HAVE_AVX512_KERNELS 0
+#endif
+#endif
+
+// File descriptors, mmap and friends for the command line tool
+#if defined(__has_include)
+#if __has_include(<sys/mman.h>) && __has_include(<unistd.h>)
+#define MULTIBASE_HAVE_POSIX_IO 1
+#endif
+#endif
+#ifndef MULTIBASE_HAVE_POSIX_IO
+#define MULTIBASE_HAVE_POSIX_IO 0
+#endif
+
+// io_uring through liburing, enabled by the build when it is found
+#ifndef MULTIBASE_HAVE_IO_URING
+#define MULTIBASE_HAVE_IO_URING 0
+#endif
+
+// Counters of encode and decode calls, and of their input sizes, enabled by
+// the build options MULTIBASE_WITH_INSTRUMENTATION and
+// MULTIBASE_WITH_INSTRUMENTATION_HISTOGRAM
+#ifndef MULTIBASE_INSTRUMENTATION
+#define MULTIBASE_INSTRUMENTATION 0
+#endif
+#ifndef MULTIBASE_INSTRUMENTATION_HISTOGRAM
+#define MULTIBASE_INSTRUMENTATION_HISTOGRAM 0
+#endif
+
 #endif
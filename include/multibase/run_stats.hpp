@@ -0,0 +1,67 @@
+#ifndef MULTIBASE_RUN_STATS_HPP
+#define MULTIBASE_RUN_STATS_HPP
+
+#include <chrono>       // for steady_clock, duration
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint64_t
+#include <ostream>      // for ostream
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <utility>      // for move
+#include <vector>       // for vector
+
+namespace multibase {
+
+/// Number of heap allocations made by the process so far
+std::uint64_t allocation_count() noexcept;
+
+/// Throughput and resource use of one run of the command line tool
+class run_stats {
+ public:
+  using clock = std::chrono::steady_clock;
+
+  /// Conversion of one input
+  struct file {
+    std::string name;
+    std::size_t bytes_in{0};
+    std::size_t bytes_out{0};
+    std::chrono::duration<double> elapsed{};
+  };
+
+  /// Start timing the run
+  run_stats();
+
+  void add(file converted) { files_.push_back(std::move(converted)); }
+
+  /// Print a table of the files followed by totals for the run
+  /// @param kernel Implementation selected for the encoding
+  void print(std::ostream& out, std::string_view kernel) const;
+
+  /// Print the same statistics as a single JSON object
+  void print_json(std::ostream& out, std::string_view kernel) const;
+
+ private:
+  /// Totals since the run started
+  struct usage {
+    std::chrono::duration<double> wall{};
+    std::chrono::duration<double> user{};
+    std::chrono::duration<double> system{};
+    /// Peak resident set size in bytes, or zero where unknown
+    std::size_t peak_rss{0};
+    std::uint64_t allocations{0};
+    std::size_t bytes_in{0};
+    std::size_t bytes_out{0};
+  };
+
+  [[nodiscard]] usage measure() const;
+
+  clock::time_point start_;
+  std::chrono::duration<double> start_user_{};
+  std::chrono::duration<double> start_system_{};
+  std::uint64_t start_allocations_{0};
+  std::vector<file> files_;
+};
+
+}  // namespace multibase
+
+#endif
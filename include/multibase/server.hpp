@@ -0,0 +1,47 @@
+#ifndef MULTIBASE_SERVER_HPP
+#define MULTIBASE_SERVER_HPP
+
+#include <cstddef>  // for size_t, ptrdiff_t
+#include <string>   // for string
+
+namespace multibase {
+
+/// Operations which may be requested of a server
+enum class operation : char {
+  /// Encode the payload bytes, answering with a multibase string
+  encode = 'e',
+  /// Decode the multibase string payload, answering with its bytes
+  decode = 'd',
+  /// Convert the multibase string payload to the requested encoding
+  transcode = 't',
+  /// Check the multibase string payload, answering with its decoded size as
+  /// an 8 byte big-endian number
+  validate = 'v'
+};
+
+/// Encoding character of a request which accepts any multibase prefix
+constexpr char any_encoding = '*';
+
+/// Largest request or response body accepted
+constexpr std::size_t max_frame_size = std::size_t{1} << 30U;
+
+/// Connections a socket server answers at once
+constexpr std::ptrdiff_t max_connections = 64;
+
+/** Answer requests read from the input descriptor until it is closed.
+ A request is a 4 byte big-endian length followed by a body of that many
+ bytes: the operation, the multibase prefix character of the encoding, then
+ the payload. Decode and validate requests may give any_encoding in place of
+ an encoding. Each response is a 4 byte big-endian length followed by a
+ status byte, zero for success, and the result or an error message.
+ Responses are written in the order of the requests; requests which arrive
+ together are all answered before the responses are written. */
+void serve(int input, int output);
+
+/// Listen on a Unix domain socket, serving each connection on its own thread,
+/// up to max_connections at once, until the process is stopped
+void serve_socket(const std::string& path);
+
+}  // namespace multibase
+
+#endif
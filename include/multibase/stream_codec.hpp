@@ -0,0 +1,65 @@
+#ifndef MULTIBASE_STREAM_CODEC_HPP
+#define MULTIBASE_STREAM_CODEC_HPP
+
+#include <cstddef>   // for size_t
+#include <optional>  // for optional
+
+#include <multibase/encoding.hpp>      // for encoding
+#include <multibase/input_source.hpp>  // for input_source
+#include <multibase/output_sink.hpp>   // for output_sink
+
+namespace multibase {
+
+/// Encode all remaining input to the sink. Chunkable encodings are
+/// converted a block at a time, others need the whole input at once.
+/// @param threads Number of threads between which large blocks of chunkable
+/// encodings are split
+void encode_stream(input_source& input, output_sink& output, encoding base,
+                   bool multiformat = true, std::size_t threads = 1);
+
+/// Decode all remaining input to the sink
+/// @param base Encoding of the input, or empty to read it from the multibase
+/// prefix
+/// @param threads Number of threads between which large blocks of chunkable
+/// encodings are split
+void decode_stream(input_source& input, output_sink& output,
+                   std::optional<encoding> base = std::nullopt,
+                   std::size_t threads = 1);
+
+/// Convert all remaining input to another encoding, a block at a time where
+/// the pair of encodings allows it
+/// @param from Encoding of the input, or empty to read it from the multibase
+/// prefix
+/// @param multiformat Whether to write the multibase prefix of the output
+void transcode_stream(input_source& input, output_sink& output, encoding to,
+                      std::optional<encoding> from = std::nullopt,
+                      bool multiformat = true);
+
+/// Encode each delimited record of the input separately, writing every
+/// encoded record followed by the delimiter
+void encode_records(input_source& input, output_sink& output, encoding base,
+                    char delimiter = '\n', bool multiformat = true);
+
+/// Decode each delimited record of the input separately, writing every
+/// decoded record followed by the delimiter. A record delimited by a newline
+/// may end with a carriage return, which is dropped.
+/// @param base Encoding of the records, or empty to read it from the
+/// multibase prefix of each record
+void decode_records(input_source& input, output_sink& output,
+                    char delimiter = '\n',
+                    std::optional<encoding> base = std::nullopt);
+
+/// Convert each delimited record of the input to another encoding
+/// separately, writing every converted record followed by the delimiter. A
+/// record delimited by a newline may end with a carriage return, which is
+/// dropped.
+/// @param from Encoding of the records, or empty to read it from the
+/// multibase prefix of each record
+void transcode_records(input_source& input, output_sink& output, encoding to,
+                       char delimiter = '\n',
+                       std::optional<encoding> from = std::nullopt,
+                       bool multiformat = true);
+
+}  // namespace multibase
+
+#endif
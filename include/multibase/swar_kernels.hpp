@@ -0,0 +1,26 @@
+#ifndef MULTIBASE_SWAR_KERNELS_HPP
+#define MULTIBASE_SWAR_KERNELS_HPP
+
+#include <cstddef>      // for byte
+#include <span>         // for span
+#include <string_view>  // for string_view
+
+#include <multibase/encoding.hpp>  // for encoding
+
+/** Portable base16, base32 and base64 kernels, which convert eight
+ characters at a time with 64 bit words: a table of every pair of characters
+ to encode, and arithmetic within a word to decode. The remainder is left to
+ basic_algorithm. */
+namespace multibase::swar {
+
+template <encoding T>
+std::string_view encode(std::span<const std::byte> input,
+                        std::span<char> output);
+
+template <encoding T>
+std::span<std::byte> decode(std::string_view input,
+                            std::span<std::byte> output);
+
+}  // namespace multibase::swar
+
+#endif
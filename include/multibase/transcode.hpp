@@ -0,0 +1,60 @@
+#ifndef MULTIBASE_TRANSCODE_HPP
+#define MULTIBASE_TRANSCODE_HPP
+
+#include <cstddef>      // for byte, size_t
+#include <optional>     // for optional
+#include <span>         // for span
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <vector>       // for vector
+
+#include <multibase/codec.hpp>     // for codec
+#include <multibase/encoding.hpp>  // for encoding
+
+namespace multibase {
+
+/// Converts encoded text from one encoding to another.
+/// Encodings differing only in case are converted by changing the case of
+/// the input, other pairs of power of two encodings by regrouping the bits
+/// of each character, without decoding to bytes. Any other pair is decoded
+/// into a scratch buffer which is reused from one call to the next, so it
+/// holds the bytes of the largest input converted at once: the whole input
+/// for an encoding which cannot be chunked.
+class transcoder {
+ public:
+  transcoder(encoding from, encoding to);
+
+  /// Upper bound on the size of the transcoded input
+  std::size_t transcoded_size(std::string_view input);
+
+  /// Convert input without a multibase prefix
+  /// @return view of the converted characters at the start of output
+  std::string_view transcode(std::string_view input, std::span<char> output);
+
+  /// Number of input characters which can be converted independently of
+  /// the rest, if the input can be split
+  [[nodiscard]] std::optional<std::size_t> chunk_size() const noexcept;
+
+ private:
+  enum class method { change_case, regroup, via_bytes };
+
+  encoding from_;
+  encoding to_;
+  method method_;
+  codec decoder_;
+  codec encoder_;
+  std::vector<std::byte> scratch_;
+};
+
+/// Convert a multibase string to another encoding, detecting the source
+/// encoding from its prefix
+std::string transcode(std::string_view input, encoding to,
+                      bool multiformat = true);
+
+/// Convert a string without multibase prefix from one encoding to another
+std::string transcode(std::string_view input, encoding from, encoding to,
+                      bool multiformat = true);
+
+}  // namespace multibase
+
+#endif
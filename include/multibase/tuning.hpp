@@ -0,0 +1,60 @@
+#ifndef MULTIBASE_TUNING_HPP
+#define MULTIBASE_TUNING_HPP
+
+#include <chrono>       // for milliseconds
+#include <cstddef>      // for size_t
+#include <filesystem>   // for path
+#include <string>       // for string
+#include <string_view>  // for string_view
+
+namespace multibase {
+
+/// Sizes and counts at which one way of converting overtakes another, which
+/// differ from one machine to the next
+struct tuning {
+  /// Least input in bytes passed to a vector kernel, below which the scalar
+  /// kernel of the encoding is used
+  std::size_t vector_min_size{0};
+  /// Least input in bytes worth handing to another thread
+  std::size_t parallel_min_size{std::size_t{256} << 10U};
+  /// Input converted by each thread in a round of parallel conversion
+  std::size_t segment_size{std::size_t{4} << 20U};
+  /// Threads converting a large input when every hardware thread is asked
+  /// for, or 0 for all of them
+  std::size_t threads{0};
+
+  bool operator==(const tuning&) const = default;
+};
+
+/// Values the process uses: the defaults, or the profile named by the
+/// MULTIBASE_TUNING environment variable when it can be loaded, until set
+/// by set_tuning or tune
+tuning active_tuning() noexcept;
+
+/// Use values from now on, in every thread
+void set_tuning(const tuning& values) noexcept;
+
+/// Measure the crossover points on the running machine and make them active.
+/// Values left unmeasured when the budget runs out keep their active value.
+/// Other threads see the active values until every one has been measured.
+tuning tune(std::chrono::milliseconds budget = std::chrono::seconds{2});
+
+/// Profile of values as lines of name=value, which from_profile reads
+std::string to_profile(const tuning& values);
+
+/// Read a profile written by to_profile. Names it leaves out keep their
+/// default value. Blank lines and those starting with # are ignored.
+/// @throw std::invalid_argument for an unknown name or a value which is not
+/// a number
+tuning from_profile(std::string_view profile);
+
+/// @throw std::system_error if the file cannot be written
+void save_profile(const tuning& values, const std::filesystem::path& path);
+
+/// @throw std::system_error if the file cannot be read
+/// @throw std::invalid_argument if it is not a valid profile
+tuning load_profile(const std::filesystem::path& path);
+
+}  // namespace multibase
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef MULTIBASE_URING_CODEC_HPP
+#define MULTIBASE_URING_CODEC_HPP
+
+#include <optional>  // for optional
+#include <string>    // for string
+
+#include <multibase/encoding.hpp>     // for encoding
+#include <multibase/output_sink.hpp>  // for output_sink
+
+namespace multibase {
+
+/// Whether files can be converted through io_uring: the backend was built
+/// in and the kernel allows it
+bool uring_available() noexcept;
+
+/// Encode a regular file to the regular file behind the sink through
+/// io_uring, with reads and writes of several blocks in flight while the
+/// block before them is encoded
+/// @return false, having done nothing, if the input, the output or the
+/// encoding does not suit io_uring
+bool uring_encode_file(const std::string& filename, output_sink& output,
+                       encoding base, bool multiformat = true);
+
+/// Decode a regular file to the regular file behind the sink through
+/// io_uring
+/// @param base Encoding of the input, or empty to read it from the multibase
+/// prefix
+/// @return false, having done nothing, if the input, the output or the
+/// encoding does not suit io_uring
+bool uring_decode_file(const std::string& filename, output_sink& output,
+                       std::optional<encoding> base = std::nullopt);
+
+}  // namespace multibase
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef MULTIBASE_VALIDATION_HPP
+#define MULTIBASE_VALIDATION_HPP
+
+#include <array>        // for array
+#include <cstddef>      // for size_t
+#include <optional>     // for optional
+#include <span>         // for span
+#include <string_view>  // for string_view
+
+#include "multibase/decode_table.hpp"  // for decode_table_type, invalid_value
+
+namespace multibase {
+
+/// Outcome of checking encoded input without decoding it
+struct validation_result {
+  /// Number of bytes the input decodes to
+  std::size_t decoded_size{0};
+  /// Offset of the first offending character when the input is malformed
+  std::optional<std::size_t> error_offset;
+
+  [[nodiscard]] constexpr bool valid() const noexcept {
+    return !error_offset.has_value();
+  }
+  constexpr explicit operator bool() const noexcept { return valid(); }
+};
+
+/// Inclusive range of characters accepted by an alphabet
+struct char_range {
+  unsigned char first{1};
+  unsigned char last{0};
+};
+
+/// Maximum number of disjoint character ranges in any alphabet
+constexpr std::size_t max_char_ranges = 8;
+
+/// Valid input characters of an encoding as a set of disjoint ranges, so
+/// that alphabet membership can be tested with vector range compares
+struct alphabet_ranges {
+  std::array<char_range, max_char_ranges> ranges{};
+  std::size_t size{0};
+
+  [[nodiscard]] constexpr std::span<const char_range> view() const noexcept {
+    return std::span{ranges.data(), size};
+  }
+};
+
+/** Collapse a decode table into the runs of characters it accepts */
+constexpr alphabet_ranges make_alphabet_ranges(const decode_table_type& table) {
+  auto result = alphabet_ranges{};
+  for (std::size_t i = 0; i < table.size(); ++i) {
+    if (table.at(i) == invalid_value) {
+      continue;
+    }
+    auto chr = static_cast<unsigned char>(i);
+    if (result.size > 0 && result.ranges.at(result.size - 1).last + 1U == i) {
+      result.ranges.at(result.size - 1).last = chr;
+    } else {
+      result.ranges.at(result.size++) = char_range{chr, chr};
+    }
+  }
+  return result;
+}
+
+/** Find the first character which lies outside all of the given ranges
+ @return offset of the first invalid character, or the size of the input */
+std::size_t find_invalid(std::string_view input,
+                         const alphabet_ranges& ranges) noexcept;
+
+}  // namespace multibase
+
+#endif
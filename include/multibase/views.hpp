@@ -0,0 +1,321 @@
+#ifndef MULTIBASE_VIEWS_HPP
+#define MULTIBASE_VIEWS_HPP
+
+#include <algorithm>    // for transform, min, max
+#include <cstddef>      // for byte, size_t, ptrdiff_t
+#include <cstring>      // for memmove
+#include <iterator>     // for default_sentinel_t, input_iterator_tag
+#include <limits>       // for numeric_limits
+#include <memory>       // for to_address
+#include <optional>     // for optional
+#include <ranges>       // for view_interface, all_t, input_range
+#include <span>         // for span
+#include <stdexcept>    // for invalid_argument
+#include <string_view>  // for string_view
+#include <type_traits>  // for conditional_t
+#include <utility>      // for forward, move, pair, swap
+#include <vector>       // for vector
+
+#include <multibase/codec.hpp>     // for codec, encode, decode
+#include <multibase/encoding.hpp>  // for encoding
+
+namespace multibase {
+
+namespace detail {
+
+enum class direction { encode, decode };
+
+/// Input gathered for each conversion of a view, in whole chunks
+constexpr std::size_t view_block_size = 4096;
+
+template <direction D>
+using input_type = std::conditional_t<D == direction::encode, std::byte, char>;
+
+template <direction D>
+using output_type = std::conditional_t<D == direction::encode, char, std::byte>;
+
+/// Input and output of a chunk, a single character per byte when the
+/// encoding has no chunk smaller than the whole input
+template <direction D>
+std::pair<std::size_t, std::size_t> chunk_sizes(const codec& converter) {
+  auto in = *converter.decoded_chunk_size();
+  auto out = *converter.encoded_chunk_size();
+  if constexpr (D == direction::decode) {
+    std::swap(in, out);
+  }
+  if (in > view_block_size) {
+    return {1, 1};
+  }
+  return {in, out};
+}
+
+/// Convert input with converter onto the end of output
+template <direction D>
+void append(codec& converter, std::span<const input_type<D>> input,
+            std::vector<output_type<D>>& output) {
+  const auto offset = output.size();
+  const auto space = [&] { return std::span{output}.subspan(offset); };
+  auto written = std::size_t{0};
+  // a conversion may leave its output anywhere in the space given
+  if constexpr (D == direction::encode) {
+    output.resize(offset + converter.encoded_size(input.size()));
+    const auto result = converter.encode(input, space());
+    std::memmove(space().data(), result.data(), result.size());
+    written = result.size();
+  } else {
+    const auto chars = std::string_view{input.data(), input.size()};
+    output.resize(offset + converter.decoded_size(chars));
+    const auto result = converter.decode(chars, space());
+    std::memmove(space().data(), result.data(), result.size());
+    written = result.size();
+  }
+  output.resize(offset + written);
+}
+
+/** Lazy conversion of a range, a block of whole chunks at a time, through a
+ buffer held by the view. Encodings which cannot be chunked are converted
+ whole when iteration starts. The view is single pass, and an invalid
+ character is reported by std::invalid_argument as it is reached. */
+template <std::ranges::view V, direction D>
+  requires std::ranges::input_range<V>
+class conversion_view
+    : public std::ranges::view_interface<conversion_view<V, D>> {
+  using input_type = detail::input_type<D>;
+  using output_type = detail::output_type<D>;
+
+ public:
+  class iterator {
+   public:
+    using iterator_concept = std::input_iterator_tag;
+    using value_type = output_type;
+    using difference_type = std::ptrdiff_t;
+
+    iterator() = default;
+    explicit iterator(conversion_view* parent) : parent_{parent} {}
+
+    output_type operator*() const {
+      return parent_->output_[parent_->position_];
+    }
+
+    iterator& operator++() {
+      if (++parent_->position_ == parent_->output_.size()) {
+        parent_->refill();
+      }
+      return *this;
+    }
+
+    void operator++(int) { ++*this; }
+
+    bool operator==(std::default_sentinel_t /*end*/) const {
+      return parent_->position_ == parent_->output_.size();
+    }
+
+   private:
+    conversion_view* parent_{nullptr};
+  };
+
+  /// @param base Encoding of the output, or of the input when decoding,
+  /// which is read from the multibase prefix when unset
+  /// @param multiformat Whether an encoding starts with its multibase prefix
+  conversion_view(V input, std::optional<encoding> base, bool multiformat)
+      : input_{std::move(input)}, base_{base}, multiformat_{multiformat} {}
+
+  iterator begin() {
+    start();
+    return iterator{this};
+  }
+
+  [[nodiscard]] std::default_sentinel_t end() const noexcept { return {}; }
+
+  /// Exact size of the output, found from the size of the input and, when
+  /// decoding, the padding of its last chunk
+  std::size_t size()
+    requires std::ranges::sized_range<V> &&
+             (D == direction::encode || std::ranges::forward_range<V>)
+  {
+    auto input_size = static_cast<std::size_t>(std::ranges::size(input_));
+    auto first = std::ranges::begin(input_);
+    auto base = base_;
+    if (!base) {
+      if (input_size == 0) {
+        throw std::invalid_argument{"Missing multibase prefix"};
+      }
+      base = multibase::decode(static_cast<char>(*first++));
+      --input_size;
+    }
+    auto converter = codec{*base};
+    if (!converter.encoded_chunk_size() || !converter.decoded_chunk_size()) {
+      // the output of an encoding which cannot be chunked is only known
+      // once converted
+      start();
+      return output_.size();
+    }
+    const auto [in, out] = chunk_sizes<D>(converter);
+    auto rest = input_size % in;
+    if constexpr (D == direction::decode) {
+      // a whole last chunk may still hold padding
+      rest = input_size > 0 && rest == 0 ? in : rest;
+    }
+    auto tail = std::vector<input_type>(rest);
+    if constexpr (D == direction::decode) {
+      std::ranges::transform(
+          std::ranges::next(first,
+                            static_cast<std::ptrdiff_t>(input_size - rest)),
+          std::ranges::end(input_), tail.begin(),
+          [](auto value) { return static_cast<input_type>(value); });
+    }
+    auto converted = std::vector<output_type>{};
+    append<D>(converter, tail, converted);
+    const auto prefix = std::size_t{D == direction::encode && multiformat_};
+    return prefix + (input_size - rest) / in * out + converted.size();
+  }
+
+ private:
+  void start() {
+    if (current_) {
+      return;
+    }
+    current_.emplace(std::ranges::begin(input_));
+    if (!base_) {
+      if (*current_ == std::ranges::end(input_)) {
+        throw std::invalid_argument{"Missing multibase prefix"};
+      }
+      base_ = multibase::decode(static_cast<char>(**current_));
+      ++*current_;
+    }
+    converter_.emplace(*base_);
+    if constexpr (D == direction::encode) {
+      if (multiformat_) {
+        output_.push_back(multibase::encode(*base_));
+      }
+    }
+    if (!converter_->encoded_chunk_size() ||
+        !converter_->decoded_chunk_size()) {
+      append<D>(*converter_, gather(std::numeric_limits<std::size_t>::max()),
+                output_);
+      exhausted_ = true;
+    } else if (output_.empty()) {
+      refill();
+    }
+  }
+
+  /// Replace the output with the conversion of the next block of input
+  void refill() {
+    output_.clear();
+    position_ = 0;
+    if (exhausted_) {
+      return;
+    }
+    const auto in = chunk_sizes<D>(*converter_).first;
+    const auto block = std::max(std::size_t{1}, view_block_size / in) * in;
+    while (output_.empty() && !exhausted_) {
+      const auto input = gather(block);
+      exhausted_ = input.size() < block;
+      append<D>(*converter_, input, output_);
+    }
+  }
+
+  /// Up to limit elements of the rest of the input, read in place when it
+  /// is contiguous
+  std::span<const input_type> gather(std::size_t limit) {
+    using iterator_type = std::ranges::iterator_t<V>;
+    auto& current = *current_;
+    if constexpr (std::contiguous_iterator<iterator_type> &&
+                  std::sized_sentinel_for<std::ranges::sentinel_t<V>,
+                                          iterator_type> &&
+                  sizeof(std::iter_value_t<iterator_type>) == 1) {
+      const auto count = std::min(
+          limit, static_cast<std::size_t>(std::ranges::end(input_) - current));
+      const auto* data = static_cast<const input_type*>(
+          static_cast<const void*>(std::to_address(current)));
+      current += static_cast<std::ptrdiff_t>(count);
+      return {data, count};
+    } else {
+      buffer_.clear();
+      for (; buffer_.size() < limit && current != std::ranges::end(input_);
+           ++current) {
+        buffer_.push_back(static_cast<input_type>(*current));
+      }
+      return buffer_;
+    }
+  }
+
+  V input_;
+  std::optional<encoding> base_;
+  bool multiformat_;
+  std::optional<codec> converter_;
+  std::optional<std::ranges::iterator_t<V>> current_;
+  std::vector<input_type> buffer_;
+  std::vector<output_type> output_;
+  std::size_t position_{0};
+  bool exhausted_{false};
+};
+
+}  // namespace detail
+
+template <std::ranges::view V>
+using encode_view = detail::conversion_view<V, detail::direction::encode>;
+
+template <std::ranges::view V>
+using decode_view = detail::conversion_view<V, detail::direction::decode>;
+
+/** Range adaptors converting lazily, so that a large input is never held
+ whole, e.g. `input | views::encode(encoding::base_32)` */
+namespace views {
+
+struct encode_adaptor {
+  encoding base;
+  bool multiformat;
+
+  template <std::ranges::viewable_range R>
+    requires std::ranges::input_range<R>
+  friend auto operator|(R&& input, const encode_adaptor& adaptor) {
+    return encode_view<std::views::all_t<R>>{
+        std::views::all(std::forward<R>(input)), adaptor.base,
+        adaptor.multiformat};
+  }
+};
+
+struct decode_adaptor {
+  std::optional<encoding> base;
+
+  template <std::ranges::viewable_range R>
+    requires std::ranges::input_range<R>
+  friend auto operator|(R&& input, const decode_adaptor& adaptor) {
+    return decode_view<std::views::all_t<R>>{
+        std::views::all(std::forward<R>(input)), adaptor.base, false};
+  }
+};
+
+inline encode_adaptor encode(encoding base, bool multiformat = true) {
+  return {base, multiformat};
+}
+
+/// Decode input which starts with its multibase prefix
+inline decode_adaptor decode() { return {}; }
+
+inline decode_adaptor decode(encoding base) { return {base}; }
+
+template <std::ranges::viewable_range R>
+  requires std::ranges::input_range<R>
+auto encode(R&& input, encoding base, bool multiformat = true) {
+  return std::forward<R>(input) | encode(base, multiformat);
+}
+
+template <std::ranges::viewable_range R>
+  requires std::ranges::input_range<R>
+auto decode(R&& input) {
+  return std::forward<R>(input) | decode();
+}
+
+template <std::ranges::viewable_range R>
+  requires std::ranges::input_range<R>
+auto decode(R&& input, encoding base) {
+  return std::forward<R>(input) | decode(base);
+}
+
+}  // namespace views
+
+}  // namespace multibase
+
+#endif
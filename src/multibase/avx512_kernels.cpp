@@ -0,0 +1,370 @@
+// Copyright 2023 Lockblox
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <multibase/avx512_kernels.hpp>
+
+#if MULTIBASE_HAVE_AVX512_KERNELS
+
+#include <immintrin.h>  // for _mm512_permutexvar_epi8, __m512i
+
+#include <algorithm>  // for min
+#include <array>      // for array
+#include <cstdint>    // for uint64_t, uintptr_t
+#include <cstring>    // for memcpy
+#include <stdexcept>  // for invalid_argument
+
+#include <multibase/basic_algorithm.hpp>  // for basic_algorithm
+#include <multibase/decode_table.hpp>     // for decode_table, invalid_value
+#include <multibase/dispatch.hpp>         // for streams
+#include <multibase/encoding_traits.hpp>  // for encoding_traits
+#include <multibase/instrumentation.hpp>  // for call
+#include <multibase/swar_kernels.hpp>     // for encode, decode
+#include <multibase/tuning.hpp>           // for active_tuning
+
+#define MULTIBASE_TARGET_AVX512 \
+  __attribute__((target("avx512f,avx512bw,avx512vl,avx512vbmi")))
+
+namespace multibase::avx512 {
+
+namespace {
+
+constexpr std::size_t width = 64;
+constexpr std::size_t lanes = 8;
+constexpr unsigned char invalid_lane = 0x80;
+
+/// Bits per character, which is also the bytes in each 64 bit lane of eight
+/// characters
+template <encoding T>
+constexpr std::size_t bits =
+    encoding_traits<T>::alphabet.size() == 64 ? 6 : 5;
+
+/// Bytes converted to or from 64 characters
+template <encoding T>
+constexpr std::size_t block = bits<T> * lanes;
+
+using table = std::array<unsigned char, width>;
+
+/// The alphabet repeated to fill the table, so that the bits of an index
+/// above the alphabet size are ignored
+template <encoding T>
+constexpr table make_alphabet() {
+  constexpr auto& alphabet = encoding_traits<T>::alphabet;
+  auto result = table{};
+  for (std::size_t i = 0; i < width; ++i) {
+    result.at(i) =
+        static_cast<unsigned char>(alphabet.at(i % alphabet.size()));
+  }
+  return result;
+}
+
+/// Gather the bytes of each group big end first, least significant byte at
+/// the bottom of its lane, so that characters are fields of the lane
+template <encoding T>
+constexpr table make_gather() {
+  auto result = table{};
+  for (std::size_t lane = 0; lane < lanes; ++lane) {
+    for (std::size_t i = 0; i < bits<T>; ++i) {
+      result.at(lane * lanes + i) =
+          static_cast<unsigned char>(lane * bits<T> + bits<T> - 1 - i);
+    }
+  }
+  return result;
+}
+
+/// Bit offset in its lane of each character, the first the highest
+template <encoding T>
+constexpr std::uint64_t make_shifts() {
+  auto result = std::uint64_t{0};
+  for (std::size_t i = 0; i < lanes; ++i) {
+    result |= std::uint64_t{(lanes - 1 - i) * bits<T>} << (i * lanes);
+  }
+  return result;
+}
+
+/// Bytes of each lane of packed values, taken big end first
+template <encoding T>
+constexpr table make_scatter() {
+  // base64 packs each four characters into a 32 bit lane, base32 each
+  // eight into a 64 bit one
+  constexpr std::size_t group = bits<T> == 6 ? 3 : 5;
+  constexpr std::size_t stride = bits<T> == 6 ? 4 : 8;
+  auto result = table{};
+  for (std::size_t i = 0; i < block<T>; ++i) {
+    result.at(i) = static_cast<unsigned char>(i / group * stride + group - 1 -
+                                              i % group);
+  }
+  return result;
+}
+
+/// Value of each seven bit character, with the top bit set on those outside
+/// the alphabet, padding included
+template <encoding T>
+constexpr std::array<unsigned char, 2 * width> make_values() {
+  auto result = std::array<unsigned char, 2 * width>{};
+  for (std::size_t i = 0; i < result.size(); ++i) {
+    const auto value = decode_table<T>.at(i);
+    result.at(i) = value == invalid_value ? invalid_lane : value;
+  }
+  return result;
+}
+
+template <encoding T>
+constexpr auto alphabet = make_alphabet<T>();
+template <encoding T>
+constexpr auto gather = make_gather<T>();
+template <encoding T>
+constexpr auto scatter = make_scatter<T>();
+template <encoding T>
+constexpr auto values = make_values<T>();
+
+// GCC 12 builds the permute and shift intrinsics on _mm512_undefined_epi32,
+// which it then reports as read uninitialised wherever they are inlined
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+/// Combine each eight characters of values into the bytes they encode,
+/// least significant first in each lane
+template <encoding T>
+MULTIBASE_TARGET_AVX512 __m512i pack(__m512i chars) {
+  if constexpr (bits<T> == 6) {
+    // a * 64 + b in each 16 bits, then ab * 4096 + cd in each 32
+    const auto pairs =
+        _mm512_maddubs_epi16(chars, _mm512_set1_epi32(0x01400140));
+    return _mm512_madd_epi16(pairs, _mm512_set1_epi32(0x00011000));
+  } else {
+    // 10 bits in each 16, 20 in each 32, then the first 20 above the second
+    // in each 64
+    const auto pairs =
+        _mm512_maddubs_epi16(chars, _mm512_set1_epi32(0x01200120));
+    const auto quads = _mm512_madd_epi16(pairs, _mm512_set1_epi32(0x00010400));
+    constexpr auto high_field = 0xfffff00000LL;
+    return _mm512_or_si512(_mm512_and_si512(_mm512_slli_epi64(quads, 20),
+                                            _mm512_set1_epi64(high_field)),
+                           _mm512_srli_epi64(quads, 32));
+  }
+}
+
+/// Output of each round of streaming, which stays in the first level cache
+/// until copied out
+constexpr std::size_t staging_size = 4096;
+
+/// How far ahead of the kernel to prefetch input when streaming
+constexpr std::size_t prefetch_distance = 1024;
+
+/// Prefetch input for a kernel which streams its output, keeping it out of
+/// the outer caches as far as the processor allows
+template <bool prefetch>
+MULTIBASE_TARGET_AVX512 void prefetch_input(const void* input) {
+  if constexpr (prefetch) {
+    _mm_prefetch(static_cast<const char*>(input) + prefetch_distance,
+                 _MM_HINT_NTA);
+  }
+}
+
+/// Offset of data within its cache line
+std::size_t line_offset(const void* data) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  return reinterpret_cast<std::uintptr_t>(data) % width;
+}
+
+/// Copy size bytes from source, at the same offset in its cache line as
+/// output, with a non-temporal store of each whole line of output
+MULTIBASE_TARGET_AVX512 void stream_copy(const void* source, std::size_t size,
+                                         void* output) {
+  const auto* from = static_cast<const char*>(source);
+  auto* to = static_cast<char*>(output);
+  const auto head = std::min(size, (width - line_offset(to)) % width);
+  std::memcpy(to, from, head);
+  auto offset = head;
+  for (; offset + width <= size; offset += width) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    _mm512_stream_si512(reinterpret_cast<__m512i*>(to + offset),
+                        _mm512_load_si512(from + offset));
+  }
+  std::memcpy(to + offset, from + offset, size - offset);
+}
+
+/// Encode whole blocks of input into 64 characters each
+template <encoding T, bool prefetch = false>
+MULTIBASE_TARGET_AVX512 void encode_blocks(const std::byte* input,
+                                           std::size_t blocks, char* output) {
+  const auto gathered = _mm512_loadu_si512(gather<T>.data());
+  const auto shifts =
+      _mm512_set1_epi64(static_cast<long long>(make_shifts<T>()));
+  const auto lookup = _mm512_loadu_si512(alphabet<T>.data());
+  constexpr auto input_mask = static_cast<__mmask64>((1ULL << block<T>) - 1);
+  for (std::size_t i = 0; i < blocks; ++i) {
+    prefetch_input<prefetch>(input);
+    const auto bytes = _mm512_maskz_loadu_epi8(input_mask, input);
+    const auto grouped = _mm512_permutexvar_epi8(gathered, bytes);
+    const auto indices = _mm512_multishift_epi64_epi8(shifts, grouped);
+    _mm512_storeu_si512(output, _mm512_permutexvar_epi8(indices, lookup));
+    input += block<T>;
+    output += width;
+  }
+}
+
+/// Decode up to blocks of 64 characters, stopping at one which holds
+/// anything but alphabet characters, such as padding
+/// @return number of blocks decoded
+template <encoding T, bool prefetch = false>
+MULTIBASE_TARGET_AVX512 std::size_t decode_blocks(const char* input,
+                                                  std::size_t blocks,
+                                                  std::byte* output) {
+  const auto low = _mm512_loadu_si512(values<T>.data());
+  const auto high = _mm512_loadu_si512(&values<T>[width]);
+  const auto scattered = _mm512_loadu_si512(scatter<T>.data());
+  constexpr auto output_mask = static_cast<__mmask64>((1ULL << block<T>) - 1);
+  for (std::size_t i = 0; i < blocks; ++i) {
+    prefetch_input<prefetch>(input);
+    const auto chars = _mm512_loadu_si512(input);
+    const auto decoded = _mm512_permutex2var_epi8(low, chars, high);
+    if (_mm512_movepi8_mask(_mm512_or_si512(chars, decoded)) != 0) {
+      return i;
+    }
+    _mm512_mask_storeu_epi8(output, output_mask,
+                            _mm512_permutexvar_epi8(scattered,
+                                                    pack<T>(decoded)));
+    input += width;
+    output += block<T>;
+  }
+  return blocks;
+}
+
+/// Encode blocks a round at a time into a staging buffer, then stream each
+/// round to the output
+template <encoding T>
+MULTIBASE_TARGET_AVX512 void stream_encode_blocks(const std::byte* input,
+                                                  std::size_t blocks,
+                                                  char* output) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-member-init)
+  alignas(width) std::array<char, staging_size + width> staging;
+  constexpr auto round = staging_size / width;
+  while (blocks > 0) {
+    const auto count = std::min(blocks, round);
+    auto* staged = &staging.at(line_offset(output));
+    encode_blocks<T, true>(input, count, staged);
+    stream_copy(staged, count * width, output);
+    input += count * block<T>;
+    output += count * width;
+    blocks -= count;
+  }
+  _mm_sfence();
+}
+
+/// Decode blocks as decode_blocks does, streaming a round at a time
+template <encoding T>
+MULTIBASE_TARGET_AVX512 std::size_t stream_decode_blocks(const char* input,
+                                                         std::size_t blocks,
+                                                         std::byte* output) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-member-init)
+  alignas(width) std::array<std::byte, staging_size + width> staging;
+  constexpr auto round = staging_size / block<T>;
+  auto decoded = std::size_t{0};
+  while (decoded < blocks) {
+    const auto count = std::min(blocks - decoded, round);
+    auto* staged = &staging.at(line_offset(output));
+    const auto done = decode_blocks<T, true>(input, count, staged);
+    stream_copy(staged, done * block<T>, output);
+    decoded += done;
+    if (done < count) {
+      break;
+    }
+    input += count * width;
+    output += count * block<T>;
+  }
+  _mm_sfence();
+  return decoded;
+}
+
+#pragma GCC diagnostic pop
+
+}  // namespace
+
+template <encoding T>
+std::string_view encode(std::span<const std::byte> input,
+                        std::span<char> output) {
+  if (input.size() < active_tuning().vector_min_size) {
+    return swar::encode<T>(input, output);
+  }
+  auto measured = instrumentation::call{T, instrumentation::operation::encode,
+                                        input.size()};
+  constexpr auto byte_bits = std::size_t{8};
+  const auto size =
+      encoding_traits<T>::padding != 0
+          ? basic_algorithm<T>::encoded_size(input.size())
+          : (input.size() * byte_bits + bits<T> - 1) / bits<T>;
+  // too small an output is left for the portable implementation to report
+  const auto blocks = output.size() < size ? 0 : input.size() / block<T>;
+  if (streams(size)) {
+    stream_encode_blocks<T>(input.data(), blocks, output.data());
+  } else {
+    encode_blocks<T>(input.data(), blocks, output.data());
+  }
+  const auto written = blocks * width;
+  const auto tail = basic_algorithm<T>::encode(
+      input.subspan(blocks * block<T>), output.subspan(written));
+  return measured.finish(
+      std::string_view{output.data(), written + tail.size()});
+}
+
+template <encoding T>
+std::span<std::byte> decode(std::string_view input,
+                            std::span<std::byte> output) {
+  if (input.size() < active_tuning().vector_min_size) {
+    return swar::decode<T>(input, output);
+  }
+  auto measured = instrumentation::call{T, instrumentation::operation::decode,
+                                        input.size()};
+  // the portable implementation takes the rest of the input from the first
+  // block which is not plain alphabet or would overrun the output
+  const auto limit = std::min(input.size() / width, output.size() / block<T>);
+  const auto blocks =
+      streams(limit * block<T>)
+          ? stream_decode_blocks<T>(input.data(), limit, output.data())
+          : decode_blocks<T>(input.data(), limit, output.data());
+  const auto written = blocks * block<T>;
+  try {
+    const auto tail = basic_algorithm<T>::decode(input.substr(blocks * width),
+                                                 output.subspan(written));
+    return measured.finish(std::span{output.data(), written + tail.size()});
+  } catch (const std::invalid_argument&) {
+    // report the error as it would be for the whole input
+    return measured.finish(basic_algorithm<T>::decode(input, output));
+  }
+}
+
+#define MULTIBASE_AVX512_KERNEL(base)                                       \
+  template std::string_view encode<encoding::base>(                         \
+      std::span<const std::byte>, std::span<char>);                         \
+  template std::span<std::byte> decode<encoding::base>(std::string_view,    \
+                                                       std::span<std::byte>)
+
+MULTIBASE_AVX512_KERNEL(base_32);
+MULTIBASE_AVX512_KERNEL(base_32_upper);
+MULTIBASE_AVX512_KERNEL(base_32_pad);
+MULTIBASE_AVX512_KERNEL(base_32_pad_upper);
+MULTIBASE_AVX512_KERNEL(base_32_hex);
+MULTIBASE_AVX512_KERNEL(base_32_hex_upper);
+MULTIBASE_AVX512_KERNEL(base_32_hex_pad);
+MULTIBASE_AVX512_KERNEL(base_32_hex_pad_upper);
+MULTIBASE_AVX512_KERNEL(base_32_z);
+MULTIBASE_AVX512_KERNEL(base_64);
+MULTIBASE_AVX512_KERNEL(base_64_pad);
+MULTIBASE_AVX512_KERNEL(base_64_url);
+MULTIBASE_AVX512_KERNEL(base_64_url_pad);
+
+}  // namespace multibase::avx512
+
+#endif
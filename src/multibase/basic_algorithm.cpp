@@ -20,12 +20,14 @@ template <>
 std::string_view
 basic_algorithm<encoding::base_none, encoding_traits<encoding::base_none>>::
     encode(std::span<const std::byte> chunk, std::span<char> output) {
+  auto measured = instrumentation::call{
+      encoding::base_none, instrumentation::operation::encode, chunk.size()};
   auto result = std::ranges::transform(
       chunk, output.begin(), [](auto byte) { return static_cast<char>(byte); });
   auto output_view = std::string_view{
       output.data(),
       static_cast<std::size_t>(std::distance(output.begin(), result.out))};
-  return output_view;
+  return measured.finish(output_view);
 }
 
 template <>
@@ -33,11 +35,14 @@ std::span<std::byte> basic_algorithm<
     encoding::base_none,
     encoding_traits<encoding::base_none>>::decode(std::string_view chunk,
                                                   std::span<std::byte> output) {
+  auto measured = instrumentation::call{
+      encoding::base_none, instrumentation::operation::decode, chunk.size()};
   auto result = std::ranges::transform(chunk, output.begin(), [](auto chr) {
     return std::byte{static_cast<unsigned char>(chr)};
   });
-  return std::span{output.data(), static_cast<std::size_t>(std::distance(
-                                      output.begin(), result.out))};
+  return measured.finish(std::span{
+      output.data(), static_cast<std::size_t>(
+                         std::distance(output.begin(), result.out))});
 }
 
 }  // namespace multibase
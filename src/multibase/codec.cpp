@@ -126,6 +126,10 @@ std::span<std::byte> codec::decode(std::string_view input,
   return decoded_chunk_size_();
 }
 
+validation_result codec::validate(std::string_view input) {
+  return validate_(input);
+}
+
 char encode(encoding base) {
   return static_cast<std::underlying_type_t<multibase::encoding>>(base);
 }
@@ -138,4 +142,20 @@ encoding decode(char byte) {
   return *base;
 }
 
+validation_result validate(std::string_view input,
+                           std::optional<encoding> base) {
+  if (input.empty()) {
+    return {0, 0};
+  }
+  auto prefix = magic_enum::enum_cast<encoding>(input.front());
+  if (!prefix || (base && *base != *prefix)) {
+    return {0, 0};
+  }
+  auto result = codec{*prefix}.validate(input.substr(1));
+  if (result.error_offset) {
+    ++*result.error_offset;
+  }
+  return result;
+}
+
 }  // namespace multibase
@@ -0,0 +1,326 @@
+// Copyright 2023 Lockblox
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <multibase/dispatch.hpp>
+
+#include <algorithm>     // for min, max
+#include <array>         // for array
+#include <atomic>        // for atomic, memory_order_relaxed
+#include <charconv>      // for from_chars
+#include <cstdint>       // for uint32_t, uint64_t
+#include <cstdlib>       // for getenv
+#include <cstring>       // for strlen
+#include <system_error>  // for errc
+#include <utility>       // for exchange
+
+#include <magic_enum.hpp>  // for enum_cast
+
+#include <multibase/avx512_kernels.hpp>  // for encode, decode
+#include <multibase/swar_kernels.hpp>    // for encode, decode
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>  // for __get_cpuid_count
+#define MULTIBASE_X86 1
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>  // for __cpuidex, _xgetbv
+#define MULTIBASE_X86 1
+#else
+#define MULTIBASE_X86 0
+#endif
+
+namespace multibase {
+
+namespace {
+
+template <encoding T>
+constexpr auto swar = kernel{T, isa::swar, "swar", &swar::encode<T>,
+                             &swar::decode<T>};
+
+#if MULTIBASE_HAVE_AVX512_KERNELS
+template <encoding T>
+constexpr auto avx512_vbmi = kernel{T, isa::avx512, "avx512vbmi",
+                                    &avx512::encode<T>, &avx512::decode<T>};
+#endif
+
+/// Kernels compiled into the library, which take the place of the portable
+/// implementation when the active level allows
+constexpr auto kernels = std::array{
+    swar<encoding::base_16>,
+    swar<encoding::base_16_upper>,
+    swar<encoding::base_32>,
+    swar<encoding::base_32_upper>,
+    swar<encoding::base_32_pad>,
+    swar<encoding::base_32_pad_upper>,
+    swar<encoding::base_32_hex>,
+    swar<encoding::base_32_hex_upper>,
+    swar<encoding::base_32_hex_pad>,
+    swar<encoding::base_32_hex_pad_upper>,
+    swar<encoding::base_32_z>,
+    swar<encoding::base_64>,
+    swar<encoding::base_64_pad>,
+    swar<encoding::base_64_url>,
+    swar<encoding::base_64_url_pad>,
+#if MULTIBASE_HAVE_AVX512_KERNELS
+    avx512_vbmi<encoding::base_32>,
+    avx512_vbmi<encoding::base_32_upper>,
+    avx512_vbmi<encoding::base_32_pad>,
+    avx512_vbmi<encoding::base_32_pad_upper>,
+    avx512_vbmi<encoding::base_32_hex>,
+    avx512_vbmi<encoding::base_32_hex_upper>,
+    avx512_vbmi<encoding::base_32_hex_pad>,
+    avx512_vbmi<encoding::base_32_hex_pad_upper>,
+    avx512_vbmi<encoding::base_32_z>,
+    avx512_vbmi<encoding::base_64>,
+    avx512_vbmi<encoding::base_64_pad>,
+    avx512_vbmi<encoding::base_64_url>,
+    avx512_vbmi<encoding::base_64_url_pad>,
+#endif
+};
+
+constexpr auto isa_levels = static_cast<std::size_t>(isa::avx512) + 1;
+
+/// Kernel of each level for each encoding, indexed by the level and by the
+/// prefix character of the encoding, so that codecs select theirs with a
+/// lookup rather than a search of the kernels
+constexpr auto selections = []() {
+  constexpr auto prefixes = std::size_t{256};
+  auto result = std::array<std::array<const kernel*, prefixes>, isa_levels>{};
+  for (const auto& candidate : kernels) {
+    for (auto level = static_cast<std::size_t>(candidate.level);
+         level < isa_levels; ++level) {
+      auto& selected =
+          result.at(level).at(static_cast<unsigned char>(candidate.base));
+      if (selected == nullptr || candidate.level > selected->level) {
+        selected = &candidate;
+      }
+    }
+  }
+  return result;
+}();
+
+#if MULTIBASE_X86
+struct registers {
+  std::uint32_t eax{0};
+  std::uint32_t ebx{0};
+  std::uint32_t ecx{0};
+  std::uint32_t edx{0};
+};
+
+registers cpuid(std::uint32_t leaf, std::uint32_t subleaf) {
+  auto result = registers{};
+#if defined(_MSC_VER)
+  auto values = std::array<int, 4>{};
+  __cpuidex(values.data(), static_cast<int>(leaf), static_cast<int>(subleaf));
+  result = {static_cast<std::uint32_t>(values[0]),
+            static_cast<std::uint32_t>(values[1]),
+            static_cast<std::uint32_t>(values[2]),
+            static_cast<std::uint32_t>(values[3])};
+#else
+  if (__get_cpuid_count(leaf, subleaf, &result.eax, &result.ebx, &result.ecx,
+                        &result.edx) == 0) {
+    return {};
+  }
+#endif
+  return result;
+}
+
+/// Register state the operating system saves on a context switch
+std::uint64_t saved_state() {
+#if defined(_MSC_VER)
+  return _xgetbv(0);
+#else
+  std::uint32_t low = 0;
+  std::uint32_t high = 0;
+  asm("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+  return (std::uint64_t{high} << 32U) | low;
+#endif
+}
+
+/// Size of the largest cache described by the deterministic cache
+/// parameters of leaf, numbered 4 by Intel and 0x8000001d by AMD
+std::size_t largest_cache(std::uint32_t leaf) {
+  auto result = std::size_t{0};
+  constexpr auto type_mask = 0x1fU;
+  constexpr auto max_subleaf = 16U;
+  for (auto subleaf = 0U; subleaf < max_subleaf; ++subleaf) {
+    const auto cache = cpuid(leaf, subleaf);
+    if ((cache.eax & type_mask) == 0) {
+      break;
+    }
+    const auto ways = (cache.ebx >> 22U) + 1;
+    const auto partitions = ((cache.ebx >> 12U) & 0x3ffU) + 1;
+    const auto line = (cache.ebx & 0xfffU) + 1;
+    const auto sets = std::size_t{cache.ecx} + 1;
+    result = std::max(result, ways * partitions * line * sets);
+  }
+  return result;
+}
+
+std::size_t last_level_cache() {
+  constexpr auto intel_leaf = 4U;
+  constexpr auto amd_leaf = 0x8000001dU;
+  auto result = std::size_t{0};
+  if (cpuid(0, 0).eax >= intel_leaf) {
+    result = largest_cache(intel_leaf);
+  }
+  if (result == 0 && cpuid(0x80000000U, 0).eax >= amd_leaf) {
+    result = largest_cache(amd_leaf);
+  }
+  return result;
+}
+
+constexpr bool has(std::uint32_t value, unsigned bit) {
+  return ((value >> bit) & 1U) != 0;
+}
+
+isa detect() {
+  const auto basic = cpuid(0, 0);
+  const auto features = cpuid(1, 0);
+  constexpr auto ssse3 = 9U;
+  constexpr auto sse41 = 19U;
+  constexpr auto osxsave = 27U;
+  if (!has(features.ecx, ssse3) || !has(features.ecx, sse41)) {
+    return isa::swar;
+  }
+  constexpr auto extended_leaf = 7U;
+  if (basic.eax < extended_leaf || !has(features.ecx, osxsave)) {
+    return isa::sse4;
+  }
+  constexpr auto avx = 28U;
+  // XMM and YMM, then opmask and both halves of ZMM
+  constexpr auto ymm_state = std::uint64_t{0x6};
+  constexpr auto zmm_state = std::uint64_t{0xe0};
+  const auto state = saved_state();
+  const auto extended = cpuid(extended_leaf, 0);
+  constexpr auto avx2 = 5U;
+  constexpr auto bmi2 = 8U;
+  if (!has(features.ecx, avx) || (state & ymm_state) != ymm_state ||
+      !has(extended.ebx, avx2) || !has(extended.ebx, bmi2)) {
+    return isa::sse4;
+  }
+  constexpr auto avx512f = 16U;
+  constexpr auto avx512bw = 30U;
+  constexpr auto avx512vl = 31U;
+  constexpr auto avx512vbmi = 1U;
+  if ((state & zmm_state) != zmm_state || !has(extended.ebx, avx512f) ||
+      !has(extended.ebx, avx512bw) || !has(extended.ebx, avx512vl) ||
+      !has(extended.ecx, avx512vbmi)) {
+    return isa::avx2;
+  }
+  return isa::avx512;
+}
+#else
+isa detect() { return isa::swar; }
+
+std::size_t last_level_cache() { return 0; }
+#endif
+
+/// The detected level, lowered by MULTIBASE_ISA when it names a level
+isa initial_level() {
+  auto level = detected_isa();
+  // NOLINTNEXTLINE(concurrency-mt-unsafe)
+  if (const auto* name = std::getenv("MULTIBASE_ISA")) {
+    if (auto requested = magic_enum::enum_cast<isa>(name)) {
+      level = std::min(level, *requested);
+    }
+  }
+  return level;
+}
+
+std::atomic<isa>& level() {
+  static auto result = std::atomic<isa>{initial_level()};
+  return result;
+}
+
+/// Half the last level cache, or MULTIBASE_STREAMING_THRESHOLD when it is a
+/// number of bytes
+std::size_t initial_threshold() {
+  // NOLINTNEXTLINE(concurrency-mt-unsafe)
+  if (const auto* value = std::getenv("MULTIBASE_STREAMING_THRESHOLD")) {
+    auto bytes = std::size_t{0};
+    const auto* last = value + std::strlen(value);
+    if (auto [end, error] = std::from_chars(value, last, bytes);
+        error == std::errc{} && end == last) {
+      return bytes;
+    }
+  }
+  // when the cache is unknown, assume one of 8 MiB
+  constexpr auto assumed_cache = std::size_t{8} << 20U;
+  const auto cache = last_level_cache();
+  return (cache != 0 ? cache : assumed_cache) / 2;
+}
+
+std::atomic<std::size_t>& threshold() {
+  static auto result = std::atomic<std::size_t>{initial_threshold()};
+  return result;
+}
+
+thread_local auto mode = store_mode::automatic;
+
+}  // namespace
+
+isa detected_isa() noexcept {
+  static const auto result = detect();
+  return result;
+}
+
+isa active_isa() noexcept { return level().load(std::memory_order_relaxed); }
+
+isa set_isa(isa requested) noexcept {
+  const auto result = std::min(requested, detected_isa());
+  level().store(result, std::memory_order_relaxed);
+  return result;
+}
+
+const kernel* select_kernel(encoding base) noexcept {
+  return select_kernel(base, active_isa());
+}
+
+const kernel* select_kernel(encoding base, isa limit) noexcept {
+  return selections.at(static_cast<std::size_t>(limit))
+      .at(static_cast<unsigned char>(base));
+}
+
+std::string_view active_kernel(encoding base) noexcept {
+  const auto* selected = select_kernel(base);
+  return selected != nullptr ? selected->name : "scalar";
+}
+
+store_mode active_store_mode() noexcept { return mode; }
+
+store_mode set_store_mode(store_mode requested) noexcept {
+  return std::exchange(mode, requested);
+}
+
+std::size_t streaming_threshold() noexcept {
+  return threshold().load(std::memory_order_relaxed);
+}
+
+void set_streaming_threshold(std::size_t bytes) noexcept {
+  threshold().store(bytes, std::memory_order_relaxed);
+}
+
+bool streams(std::size_t size) noexcept {
+  switch (mode) {
+    case store_mode::automatic:
+      return size >= streaming_threshold();
+    case store_mode::cached:
+      return false;
+    case store_mode::streaming:
+      return true;
+  }
+  return false;
+}
+
+}  // namespace multibase
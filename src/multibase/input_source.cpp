@@ -0,0 +1,228 @@
+// Copyright 2023 Lockblox
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <multibase/input_source.hpp>
+
+#include <algorithm>     // for min
+#include <cerrno>        // for errno, EINTR
+#include <system_error>  // for system_error, generic_category
+#include <utility>       // for exchange
+
+#include <multibase/output_sink.hpp>  // for output_sink
+#include <multibase/portability.hpp>  // for MULTIBASE_HAVE_POSIX_IO
+
+#if MULTIBASE_HAVE_POSIX_IO
+#include <fcntl.h>     // for open, O_RDONLY
+#include <sys/mman.h>  // for mmap, munmap, madvise
+#include <sys/stat.h>  // for fstat, S_ISREG
+#include <unistd.h>    // for read, close, lseek
+#else
+#include <fcntl.h>  // for _O_RDONLY, _O_BINARY
+#include <io.h>     // for _open, _read, _close
+#endif
+
+#if defined(__linux__)
+#include <fcntl.h>         // for splice
+#include <sys/sendfile.h>  // for sendfile
+#endif
+
+namespace multibase {
+
+input_source::input_source() : fd_{0} {
+#if !MULTIBASE_HAVE_POSIX_IO
+  ::_setmode(fd_, _O_BINARY);
+#endif
+  init();
+}
+
+input_source::input_source(const std::string& filename) : owns_fd_{true} {
+#if MULTIBASE_HAVE_POSIX_IO
+  fd_ = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);  // NOLINT
+#else
+  fd_ = ::_open(filename.c_str(), _O_RDONLY | _O_BINARY);
+#endif
+  if (fd_ < 0) {
+    throw std::system_error{errno, std::generic_category(), filename};
+  }
+  init();
+}
+
+input_source::input_source(input_source&& other) noexcept
+    : fd_{std::exchange(other.fd_, -1)},
+      owns_fd_{std::exchange(other.owns_fd_, false)},
+      map_{std::exchange(other.map_, nullptr)},
+      map_size_{std::exchange(other.map_size_, 0)},
+      position_{std::exchange(other.position_, 0)},
+      consumed_{std::exchange(other.consumed_, 0)},
+      buffer_{std::move(other.buffer_)},
+      contents_{std::move(other.contents_)} {}
+
+input_source& input_source::operator=(input_source&& other) noexcept {
+  if (this != &other) {
+    release();
+    fd_ = std::exchange(other.fd_, -1);
+    owns_fd_ = std::exchange(other.owns_fd_, false);
+    map_ = std::exchange(other.map_, nullptr);
+    map_size_ = std::exchange(other.map_size_, 0);
+    position_ = std::exchange(other.position_, 0);
+    consumed_ = std::exchange(other.consumed_, 0);
+    buffer_ = std::move(other.buffer_);
+    contents_ = std::move(other.contents_);
+  }
+  return *this;
+}
+
+input_source::~input_source() { release(); }
+
+void input_source::init() {
+#if MULTIBASE_HAVE_POSIX_IO
+  struct stat info {};
+  if (::fstat(fd_, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+    auto size = static_cast<std::size_t>(info.st_size);
+    auto* map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (map != MAP_FAILED) {  // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+      ::madvise(map, size, MADV_SEQUENTIAL);
+      map_ = static_cast<std::byte*>(map);
+      map_size_ = size;
+      // a redirected standard input need not start at the beginning
+      auto offset = ::lseek(fd_, 0, SEEK_CUR);
+      position_ = offset > 0 ? std::min(static_cast<std::size_t>(offset), size)
+                             : 0;
+      return;
+    }
+  }
+#endif
+  buffer_ = aligned_buffer{block_size};
+}
+
+void input_source::release() noexcept {
+#if MULTIBASE_HAVE_POSIX_IO
+  if (map_ != nullptr) {
+    ::munmap(map_, map_size_);
+    map_ = nullptr;
+  }
+  if (owns_fd_ && fd_ >= 0) {
+    ::close(fd_);
+  }
+#else
+  if (owns_fd_ && fd_ >= 0) {
+    ::_close(fd_);
+  }
+#endif
+  fd_ = -1;
+  owns_fd_ = false;
+}
+
+std::size_t input_source::read_some(std::span<std::byte> buffer) {
+  for (;;) {
+#if MULTIBASE_HAVE_POSIX_IO
+    auto count = ::read(fd_, buffer.data(), buffer.size());
+#else
+    auto count = ::_read(fd_, buffer.data(),
+                         static_cast<unsigned>(buffer.size()));
+#endif
+    if (count >= 0) {
+      return static_cast<std::size_t>(count);
+    }
+    if (errno != EINTR) {
+      throw std::system_error{errno, std::generic_category(), "read"};
+    }
+  }
+}
+
+std::span<const std::byte> input_source::next() {
+  if (map_ != nullptr) {
+    auto remaining = std::span{map_, map_size_}.subspan(position_);
+    position_ = map_size_;
+    consumed_ += remaining.size();
+    return remaining;
+  }
+  // fill the whole block unless the input runs out, so that only the final
+  // block is short
+  auto block = buffer_.span();
+  auto filled = std::size_t{0};
+  while (filled < block.size()) {
+    auto count = read_some(block.subspan(filled));
+    if (count == 0) {
+      break;
+    }
+    filled += count;
+  }
+  consumed_ += filled;
+  return block.first(filled);
+}
+
+std::span<const std::byte> input_source::read_all() {
+  if (map_ != nullptr) {
+    return next();
+  }
+  contents_.clear();
+  for (auto block = next(); !block.empty(); block = next()) {
+    contents_.insert(contents_.end(), block.begin(), block.end());
+  }
+  return contents_;
+}
+
+void input_source::transfer_to(output_sink& sink) {
+  sink.flush();
+#if defined(__linux__)
+  if (sink.is_mapped() || sink.descriptor() < 0) {
+    // the output is written in place rather than through its descriptor
+  } else if (map_ != nullptr) {
+    auto offset = static_cast<off_t>(position_);
+    while (position_ < map_size_) {
+      auto count =
+          ::sendfile(sink.descriptor(), fd_, &offset, map_size_ - position_);
+      if (count <= 0) {
+        if (count < 0 && errno == EINTR) {
+          continue;
+        }
+        break;
+      }
+      position_ += static_cast<std::size_t>(count);
+      consumed_ += static_cast<std::size_t>(count);
+      sink.note_written(static_cast<std::size_t>(count));
+    }
+  } else {
+    for (;;) {
+      auto count = ::splice(fd_, nullptr, sink.descriptor(), nullptr,
+                            block_size, SPLICE_F_MOVE | SPLICE_F_MORE);
+      if (count == 0) {
+        return;
+      }
+      if (count < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        // neither side is a pipe, so copy through user space
+        break;
+      }
+      consumed_ += static_cast<std::size_t>(count);
+      sink.note_written(static_cast<std::size_t>(count));
+    }
+  }
+#endif
+  for (auto block = next(); !block.empty(); block = next()) {
+    sink.write(block);
+  }
+}
+
+std::optional<std::size_t> input_source::size() const noexcept {
+  if (map_ != nullptr) {
+    return map_size_ - position_;
+  }
+  return std::nullopt;
+}
+
+}  // namespace multibase
@@ -0,0 +1,163 @@
+// Copyright 2023 Lockblox
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <multibase/instrumentation.hpp>
+
+#include <algorithm>  // for min, erase
+#include <atomic>     // for atomic, memory_order_relaxed
+#include <bit>        // for bit_width
+#include <mutex>      // for mutex, lock_guard
+#include <vector>     // for vector
+
+namespace multibase::instrumentation {
+
+namespace {
+
+std::size_t index(encoding base, operation op) {
+  return *magic_enum::enum_index(base) * 2 +
+         static_cast<std::size_t>(op == operation::decode);
+}
+
+}  // namespace
+
+const statistics& snapshot::operator()(encoding base, operation op) const {
+  return statistics_.at(index(base, op));
+}
+
+statistics& snapshot::operator()(encoding base, operation op) {
+  return statistics_.at(index(base, op));
+}
+
+#if MULTIBASE_INSTRUMENTATION
+namespace {
+
+/// Written only by its own thread, so a relaxed load and store suffice
+/// where a shared counter would need a locked read-modify-write
+class counter {
+ public:
+  void add(std::uint64_t value) noexcept {
+    value_.store(value_.load(std::memory_order_relaxed) + value,
+                 std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] std::uint64_t get() const noexcept {
+    return value_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<std::uint64_t> value_{0};
+};
+
+struct counters {
+  counter calls;
+  counter bytes_in;
+  counter bytes_out;
+  counter errors;
+  counter nanoseconds;
+  std::array<counter, size_buckets> sizes;
+
+  void add_to(statistics& total) const noexcept {
+    total.calls += calls.get();
+    total.bytes_in += bytes_in.get();
+    total.bytes_out += bytes_out.get();
+    total.errors += errors.get();
+    total.elapsed += std::chrono::nanoseconds{nanoseconds.get()};
+    for (std::size_t i = 0; i < size_buckets; ++i) {
+      total.sizes.at(i) += sizes.at(i).get();
+    }
+  }
+};
+
+class thread_counters;
+
+/// Counters of the running threads, and the totals of those which exited
+struct registry {
+  std::mutex mutex;
+  std::vector<const thread_counters*> threads;
+  snapshot exited;
+};
+
+registry& threads() {
+  // never destroyed, as threads may exit after static destruction
+  static auto* result = new registry{};
+  return *result;
+}
+
+class thread_counters {
+ public:
+  thread_counters() {
+    auto& all = threads();
+    auto lock = std::lock_guard{all.mutex};
+    all.threads.push_back(this);
+  }
+  thread_counters(const thread_counters&) = delete;
+  thread_counters(thread_counters&&) = delete;
+  thread_counters& operator=(const thread_counters&) = delete;
+  thread_counters& operator=(thread_counters&&) = delete;
+  ~thread_counters() {
+    auto& all = threads();
+    auto lock = std::lock_guard{all.mutex};
+    add_to(all.exited);
+    std::erase(all.threads, this);
+  }
+
+  counters& at(encoding base, operation op) {
+    return counters_.at(index(base, op));
+  }
+
+  void add_to(snapshot& total) const {
+    for (auto base : magic_enum::enum_values<encoding>()) {
+      for (auto op : {operation::encode, operation::decode}) {
+        counters_.at(index(base, op)).add_to(total(base, op));
+      }
+    }
+  }
+
+ private:
+  std::array<counters, 2 * magic_enum::enum_count<encoding>()> counters_;
+};
+
+}  // namespace
+
+void call::record(std::size_t bytes_out, bool failed) const noexcept {
+  const auto elapsed = std::chrono::steady_clock::now() - start_;
+  thread_local thread_counters local;
+  auto& counted = local.at(base_, op_);
+  counted.calls.add(1);
+  counted.bytes_in.add(bytes_in_);
+  counted.bytes_out.add(bytes_out);
+  counted.errors.add(failed ? 1 : 0);
+  counted.nanoseconds.add(static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+  if constexpr (histogram) {
+    const auto bucket =
+        std::min<std::size_t>(std::bit_width(bytes_in_), size_buckets - 1);
+    counted.sizes.at(bucket).add(1);
+  }
+}
+
+snapshot read() {
+  auto& all = threads();
+  auto lock = std::lock_guard{all.mutex};
+  auto result = all.exited;
+  for (const auto* thread : all.threads) {
+    thread->add_to(result);
+  }
+  return result;
+}
+#else
+snapshot read() { return {}; }
+#endif
+
+}  // namespace multibase::instrumentation
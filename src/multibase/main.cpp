@@ -12,32 +12,90 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include <algorithm>    // for __copy_fn, __for_eac...
-#include <exception>    // for exception
-#include <fstream>      // for basic_ifstream
-#include <functional>   // for identity
-#include <iostream>     // for operator<<, endl, cout
-#include <iterator>     // for ostream_iterator
-#include <stdexcept>    // for invalid_argument
-#include <string>       // for string, operator<<
-#include <string_view>  // for string_view
-#include <vector>       // for vector
-
-#include <CLI/App.hpp>                           // for App, CLI11_PARSE
-#include <CLI/Option.hpp>                        // for Option
-#include <magic_enum.hpp>                        // for enum_values
-#include <range/v3/iterator/basic_iterator.hpp>  // for operator!=
-#include <range/v3/range_fwd.hpp>                // for cardinality
-#include <range/v3/view/subrange.hpp>            // for subrange
-
-#include "multibase/byte_ostream_iterator.hpp"
-#include "multibase/codec.hpp"              // for decode, encode
+#include <algorithm>     // for __copy_fn, __for_eac...
+#include <chrono>        // for duration
+#include <cstddef>       // for size_t
+#include <exception>     // for exception
+#include <filesystem>    // for file_size, is_regular_file
+#include <functional>    // for identity
+#include <iostream>      // for operator<<, endl, cout
+#include <iterator>      // for back_inserter
+#include <memory>        // for unique_ptr, make_unique
+#include <optional>      // for optional
+#include <stdexcept>     // for invalid_argument
+#include <string>        // for string, operator<<
+#include <string_view>   // for string_view
+#include <system_error>  // for error_code
+#include <thread>        // for thread
+#include <utility>       // for move
+#include <vector>        // for vector
+
+#include <CLI/App.hpp>     // for App, CLI11_PARSE
+#include <CLI/Option.hpp>  // for Option
+#include <magic_enum.hpp>  // for enum_values, enum_name
+
+#include "multibase/codec.hpp"              // for codec
+#include "multibase/dispatch.hpp"           // for active_kernel
 #include "multibase/encoding_metadata.hpp"  // for encoding_metadata
+#include "multibase/input_source.hpp"       // for input_source
+#include "multibase/ordered_pool.hpp"       // for for_each_ordered
+#include "multibase/output_sink.hpp"        // for output_sink
+#include "multibase/run_stats.hpp"          // for run_stats
+#include "multibase/server.hpp"             // for serve, serve_socket
+#include "multibase/stream_codec.hpp"       // for decode_stream, encode_stream
+#include "multibase/tuning.hpp"             // for tune, load_profile
+#include "multibase/uring_codec.hpp"        // for uring_encode_file
 
 namespace multibase {
 enum class encoding : char;
 }  // namespace multibase
 
+namespace {
+
+/// Size of a regular file, without opening it
+std::optional<std::size_t> file_size(const std::string& filename) {
+  auto error = std::error_code{};
+  if (!std::filesystem::is_regular_file(filename, error)) {
+    return std::nullopt;
+  }
+  auto size = std::filesystem::file_size(filename, error);
+  if (error) {
+    return std::nullopt;
+  }
+  return std::optional<std::size_t>{size};
+}
+
+/// Size of the output of converting all inputs, if it can be bounded before
+/// reading them. Encodings which cannot be chunked are left to stream.
+std::optional<std::size_t> expected_size(
+    const std::vector<std::optional<std::size_t>>& sizes, bool is_decoder,
+    const std::optional<multibase::encoding>& base, bool is_multibase) {
+  auto converter = std::optional<multibase::codec>{};
+  if (base.has_value()) {
+    converter.emplace(base.value());
+    if (!converter->decoded_chunk_size()) {
+      return std::nullopt;
+    }
+  }
+  auto total = std::size_t{0};
+  for (const auto& size : sizes) {
+    if (!size) {
+      return std::nullopt;
+    }
+    if (!converter) {
+      // no base has more than eight bits per character
+      total += *size;
+    } else if (is_decoder) {
+      total += converter->decoded_size(*size);
+    } else {
+      total += converter->encoded_size(*size) + (is_multibase ? 1 : 0);
+    }
+  }
+  return total;
+}
+
+}  // namespace
+
 int main(int argc, char** argv) {
   CLI::App app{"Convert between text and multibase encoding"};
   auto is_decoder = false;
@@ -45,6 +103,20 @@ int main(int argc, char** argv) {
   auto is_list = false;
   auto is_multibase = true;
   std::vector<std::string> filenames;
+  std::string output_name;
+  auto jobs = std::size_t{1};
+  auto threads = std::size_t{0};
+  auto is_lines = false;
+  std::string delimiter{"\n"};
+  std::string to_name;
+  std::string from_name;
+  auto is_server = false;
+  std::string socket_path;
+  auto is_uring = false;
+  auto is_stats = false;
+  auto is_stats_json = false;
+  auto is_tune = false;
+  std::string tuning_path;
 
   app.add_flag("-l,--list", is_list, "list supported encodings");
   auto* encoding_option =
@@ -54,8 +126,51 @@ int main(int argc, char** argv) {
       "-d,--decode", is_decoder,
       "Decode data\nAssuming multibase prefix if encoding is omitted\nIf "
       "decode option is not provided, input will be encoded");
-  app.require_option(1, 3);
+  app.add_option("-o,--output", output_name,
+                 "Write to a file rather than standard output\nThe file is "
+                 "preallocated and mapped where the output size is known");
+  app.add_option("-j,--jobs", jobs,
+                 "Number of files to convert concurrently\n0 uses every "
+                 "hardware thread, output keeps the order of the files");
+  app.add_option("--threads", threads,
+                 "Number of threads converting each large input\nOnly "
+                 "chunkable encodings are split, 0 uses every hardware "
+                 "thread");
+  app.add_flag("--lines", is_lines,
+               "Convert each line of the input separately\nWhen decoding "
+               "multibase, each line has its own prefix");
+  auto* delimiter_option = app.add_option(
+      "--delimiter", delimiter,
+      "Character separating records, implies --lines");
+  auto* to_option = app.add_option(
+      "--to", to_name,
+      "Convert encoded input to this encoding\nThe input encoding is taken "
+      "from its multibase prefix unless --from is given");
+  auto* from_option = app.add_option(
+      "--from", from_name,
+      "Encoding of input without multibase prefix, used with --to");
+  app.add_flag("--serve", is_server,
+               "Answer length-prefixed requests on standard input and "
+               "output\nSee multibase/server.hpp for the framing");
+  auto* socket_option =
+      app.add_option("--socket", socket_path,
+                     "Serve requests on a Unix domain socket, implies --serve");
+  app.add_flag("--io-uring", is_uring,
+               "Convert regular files to a regular file through io_uring\n"
+               "Falls back to other I/O where it is unavailable");
+  app.add_flag("--stats", is_stats,
+               "Print bytes, time, throughput and resource use to standard "
+               "error");
+  app.add_flag("--stats-json", is_stats_json,
+               "Print the statistics as JSON, implies --stats");
+  app.add_flag("--tune", is_tune,
+               "Measure the tuning of this machine and print it as a "
+               "profile\nMULTIBASE_TUNING names a profile loaded at start");
+  auto* tuning_option = app.add_option("--tuning", tuning_path,
+                                       "Profile of tuning values to use");
   app.add_option("files", filenames, "A list of filenames")->expected(-1);
+  // at least one option, with no upper bound
+  app.require_option();
 
   CLI11_PARSE(app, argc, argv)
 
@@ -65,58 +180,199 @@ int main(int argc, char** argv) {
                             auto metadata = multibase::encoding_metadata{base};
                             std::cout << metadata.name() << "\n";
                           });
+    std::cout << std::flush;
+    if (!is_decoder && encoding_option->count() == 0 &&
+        to_option->count() == 0) {
+      return 0;
+    }
   }
 
   try {
+    if (tuning_option->count() > 0) {
+      multibase::set_tuning(multibase::load_profile(tuning_path));
+    }
+    if (is_tune) {
+      std::cout << multibase::to_profile(multibase::tune()) << std::flush;
+      return 0;
+    }
+    if (socket_option->count() > 0) {
+      multibase::serve_socket(socket_path);
+      return 0;
+    }
+    if (is_server) {
+      multibase::serve(0, 1);
+      return 0;
+    }
+    auto to = std::optional<multibase::encoding>{};
+    auto from = std::optional<multibase::encoding>{};
+    if (to_option->count() > 0) {
+      if (is_decoder || encoding_option->count() > 0) {
+        throw std::invalid_argument{
+            "--to cannot be combined with --encoding or --decode"};
+      }
+      to = multibase::encoding_metadata{to_name}.base();
+    }
+    if (from_option->count() > 0) {
+      if (!to) {
+        throw std::invalid_argument{"--from requires --to"};
+      }
+      from = multibase::encoding_metadata{from_name}.base();
+    }
     if (is_decoder && !is_multibase && encoding_option->count() == 0) {
       throw std::invalid_argument{
           "Encoding must be set when decoding non-multibase"};
     }
-    if (!is_decoder && encoding_option->count() == 0) {
+    if (!is_decoder && encoding_option->count() == 0 && !to) {
       throw std::invalid_argument{"Missing encoding"};
     }
     if (is_decoder && encoding_option->count() == 1) {
       is_multibase = false;
     }
-    auto metadata = multibase::encoding_metadata{base_name};
+    auto base = std::optional<multibase::encoding>{};
+    if (encoding_option->count() > 0) {
+      base = multibase::encoding_metadata{base_name}.base();
+    }
 
-    using istream_iterator = std::istream_iterator<unsigned char>;
-    using ostream_iterator = std::ostream_iterator<char>;
+    if (delimiter_option->count() > 0) {
+      if (delimiter.size() != 1) {
+        throw std::invalid_argument{"Delimiter must be a single character"};
+      }
+      is_lines = true;
+    }
+    if (jobs == 0) {
+      jobs = std::max(std::thread::hardware_concurrency(), 1U);
+    }
+    if (threads == 0) {
+      threads = multibase::active_tuning().threads;
+    }
+    if (threads == 0) {
+      threads = std::max(std::thread::hardware_concurrency(), 1U);
+    }
+    auto stats = std::optional<multibase::run_stats>{};
+    if (is_stats || is_stats_json) {
+      stats.emplace();
+    }
+    auto record = [&stats](const std::string& name, std::size_t bytes_in,
+                           std::size_t bytes_out,
+                           multibase::run_stats::clock::time_point start) {
+      if (stats) {
+        stats->add({name, bytes_in, bytes_out,
+                    multibase::run_stats::clock::now() - start});
+      }
+    };
+    // io_uring converts whole files a block at a time, one file after another
+    is_uring = is_uring && !is_lines && !to && multibase::uring_available();
+    auto convert = [&](multibase::input_source& input,
+                       multibase::output_sink& sink, std::size_t workers) {
+      if (to && is_lines) {
+        multibase::transcode_records(input, sink, *to, delimiter.front(),
+                                     from, is_multibase);
+      } else if (to) {
+        multibase::transcode_stream(input, sink, *to, from, is_multibase);
+      } else if (is_lines && is_decoder) {
+        multibase::decode_records(input, sink, delimiter.front(),
+                                  is_multibase ? std::nullopt : base);
+      } else if (is_lines) {
+        multibase::encode_records(input, sink, *base, delimiter.front(),
+                                  is_multibase);
+      } else if (is_decoder) {
+        multibase::decode_stream(input, sink,
+                                 is_multibase ? std::nullopt : base, workers);
+      } else {
+        multibase::encode_stream(input, sink, *base, is_multibase, workers);
+      }
+    };
 
-    // create list of input streams, will be 1 entry for std::cin
-    auto ifstreams = std::vector<std::ifstream>{};
-    auto inputs = std::vector<istream_iterator>{};
+    // standard input is only read when no files are given
+    auto standard_input = std::optional<multibase::input_source>{};
+    auto sizes = std::vector<std::optional<std::size_t>>{};
     if (filenames.empty()) {
-      std::cin >> std::noskipws;
-      inputs.emplace_back(std::cin);
+      standard_input.emplace();
+      sizes.push_back(standard_input->size());
     } else {
-      std::ranges::transform(
-          filenames, std::back_inserter(inputs),
-          [&ifstreams](const auto& file) {
-            ifstreams.emplace_back(file);
-            if (!ifstreams.back().is_open()) {
-              throw std::invalid_argument{"No such file or directory"};
-            }
-            ifstreams.back() >> std::noskipws;
-            return istream_iterator{ifstreams.back()};
-          });
+      std::ranges::transform(filenames, std::back_inserter(sizes), file_size);
+    }
+
+    auto output = std::unique_ptr<multibase::output_sink>{};
+    if (output_name.empty()) {
+      output = std::make_unique<multibase::output_sink>();
+    } else {
+      // records and transcoded input are sized one block at a time, so
+      // their output streams
+      auto size = std::optional<std::size_t>{};
+      if (!is_lines && !to && !is_uring) {
+        size = expected_size(sizes, is_decoder, base, is_multibase);
+      }
+      output = std::make_unique<multibase::output_sink>(output_name, size);
     }
 
-    std::ranges::for_each(inputs, [&](const auto& istream) {
-      auto input = ranges::subrange(istream, istream_iterator{});
-      auto output = byte_ostream_iterator{std::cout};
-      if (is_decoder) {
-        if (is_multibase) {
-          multibase::decode(input, output);
-        } else {
-          multibase::decode(input, output, metadata.base());
+    if (standard_input) {
+      const auto start = multibase::run_stats::clock::now();
+      convert(*standard_input, *output, threads);
+      record("-", standard_input->consumed(), output->written(), start);
+    } else if (jobs == 1 || filenames.size() == 1 || is_uring) {
+      std::ranges::for_each(filenames, [&](const auto& file) {
+        const auto start = multibase::run_stats::clock::now();
+        const auto written = output->written();
+        if (is_uring &&
+            (is_decoder ? multibase::uring_decode_file(
+                              file, *output, is_multibase ? std::nullopt : base)
+                        : multibase::uring_encode_file(file, *output, *base,
+                                                       is_multibase))) {
+          record(file, file_size(file).value_or(0),
+                 output->written() - written, start);
+          return;
         }
+        auto input = multibase::input_source{file};
+        convert(input, *output, threads);
+        record(file, input.consumed(), output->written() - written, start);
+      });
+    } else {
+      // each file is converted in memory on a single thread, and written out
+      // in order once all files before it are written; the window bounds the
+      // memory held
+      struct converted {
+        std::unique_ptr<multibase::output_sink> buffer;
+        multibase::run_stats::file stats;
+      };
+      multibase::for_each_ordered(
+          filenames.size(), jobs, 2 * jobs,
+          [&](std::size_t index) {
+            const auto start = multibase::run_stats::clock::now();
+            auto input = multibase::input_source{filenames[index]};
+            auto buffer = std::make_unique<multibase::output_sink>(
+                multibase::output_sink::in_memory);
+            convert(input, *buffer, 1);
+            // the time spent waiting to be written out is not counted
+            auto file = multibase::run_stats::file{
+                filenames[index], input.consumed(), buffer->written(),
+                multibase::run_stats::clock::now() - start};
+            return converted{std::move(buffer), std::move(file)};
+          },
+          [&](converted& result) {
+            output->write(result.buffer->contents());
+            if (stats) {
+              stats->add(std::move(result.stats));
+            }
+          });
+    }
+    if (output_name.empty() && !is_lines) {
+      output->write(std::string_view{"\n"});
+    }
+    output->close();
+    if (stats) {
+      // inputs decoded by prefix may each use a different kernel, so only
+      // the instruction set level is known
+      const auto named = base ? base : to;
+      const auto kernel =
+          named ? multibase::active_kernel(*named)
+                : magic_enum::enum_name(multibase::active_isa());
+      if (is_stats_json) {
+        stats->print_json(std::cerr, kernel);
       } else {
-        multibase::encode(input, ostream_iterator{std::cout}, metadata.base(),
-                          is_multibase);
+        stats->print(std::cerr, kernel);
       }
-    });
-    std::cout << "\n";
+    }
   } catch (std::exception& e) {
     std::cerr << e.what() << "\n";
     return 1;
@@ -0,0 +1,248 @@
+// Copyright 2023 Lockblox
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <multibase/output_sink.hpp>
+
+#include <algorithm>     // for copy_n, max
+#include <cerrno>        // for errno, EINTR
+#include <cstdio>        // for remove
+#include <exception>     // for uncaught_exceptions
+#include <system_error>  // for system_error, generic_category
+
+#include <multibase/portability.hpp>  // for MULTIBASE_HAVE_POSIX_IO
+
+#if MULTIBASE_HAVE_POSIX_IO
+#include <fcntl.h>     // for open, O_RDWR
+#include <sys/mman.h>  // for mmap, munmap
+#include <unistd.h>    // for write, ftruncate, STDOUT_FILENO
+#else
+#include <fcntl.h>     // for _O_BINARY
+#include <io.h>        // for _write, _setmode
+#include <sys/stat.h>  // for _S_IREAD, _S_IWRITE
+#endif
+
+namespace multibase {
+
+namespace {
+
+#if MULTIBASE_HAVE_POSIX_IO
+constexpr int stdout_descriptor = STDOUT_FILENO;
+#else
+constexpr int stdout_descriptor = 1;
+#endif
+
+void write_all(int descriptor, const char* data, std::size_t size) {
+  while (size > 0) {
+#if MULTIBASE_HAVE_POSIX_IO
+    auto count = ::write(descriptor, data, size);
+#else
+    auto count = ::_write(descriptor, data,
+                          static_cast<unsigned>(std::min<std::size_t>(
+                              size, output_sink::block_size)));
+#endif
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::system_error{errno, std::generic_category(), "write"};
+    }
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    data += count;
+    size -= static_cast<std::size_t>(count);
+  }
+}
+
+int open_output(const std::string& filename) {
+#if MULTIBASE_HAVE_POSIX_IO
+  constexpr auto mode = 0666;
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+  auto descriptor = ::open(filename.c_str(),
+                           O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, mode);
+#else
+  auto descriptor = ::_open(filename.c_str(),
+                            _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY,
+                            _S_IREAD | _S_IWRITE);
+#endif
+  if (descriptor < 0) {
+    throw std::system_error{errno, std::generic_category(), filename};
+  }
+  return descriptor;
+}
+
+}  // namespace
+
+output_sink::output_sink() : output_sink(stdout_descriptor) {}
+
+output_sink::output_sink(int descriptor)
+    : fd_{descriptor}, buffer_{block_size} {
+#if !MULTIBASE_HAVE_POSIX_IO
+  ::_setmode(descriptor, _O_BINARY);
+#endif
+}
+
+output_sink::output_sink(const std::string& filename,
+                         std::optional<std::size_t> size)
+    : fd_{open_output(filename)},
+      owns_fd_{true},
+      filename_{filename},
+      exceptions_{std::uncaught_exceptions()} {
+  if (MULTIBASE_HAVE_POSIX_IO && size && *size > 0) {
+    map(*size);
+  } else {
+    buffer_ = aligned_buffer{block_size};
+  }
+}
+
+output_sink::output_sink(in_memory_t /*tag*/) : fd_{-1} {}
+
+output_sink::~output_sink() {
+  if (!filename_.empty() && std::uncaught_exceptions() > exceptions_) {
+    discard();
+    return;
+  }
+  try {
+    close();
+  } catch (...) {  // NOLINT(bugprone-empty-catch)
+    // errors are reported by explicit calls to close
+  }
+}
+
+std::span<char> output_sink::prepare(std::size_t size) {
+  if (map_ != nullptr) {
+    if (size > map_size_ - used_) {
+      // the estimate was short, so grow the file
+      map(std::max(used_ + size, map_size_ + map_size_ / 2));
+    }
+    auto chars = std::span{static_cast<char*>(static_cast<void*>(map_)),
+                           map_size_};
+    return chars.subspan(used_);
+  }
+  if (size > buffer_.size() - used_) {
+    if (fd_ < 0) {
+      buffer_.reserve(std::max(used_ + size, 2 * buffer_.size()), used_);
+    } else {
+      flush();
+      buffer_.reserve(size, 0);
+    }
+  }
+  auto chars = std::span{
+      static_cast<char*>(static_cast<void*>(buffer_.data())), buffer_.size()};
+  return chars.subspan(used_);
+}
+
+void output_sink::commit(std::size_t size) noexcept {
+  used_ += size;
+  written_ += size;
+}
+
+void output_sink::write(std::string_view chars) {
+  if (map_ == nullptr && fd_ >= 0 && chars.size() >= buffer_.size()) {
+    flush();
+    write_all(fd_, chars.data(), chars.size());
+    written_ += chars.size();
+    return;
+  }
+  auto space = prepare(chars.size());
+  std::copy_n(chars.begin(), chars.size(), space.begin());
+  commit(chars.size());
+}
+
+void output_sink::write(std::span<const std::byte> bytes) {
+  write(std::string_view{static_cast<const char*>(
+                             static_cast<const void*>(bytes.data())),
+                         bytes.size()});
+}
+
+void output_sink::flush() {
+  if (map_ != nullptr || fd_ < 0 || used_ == 0) {
+    return;
+  }
+  auto size = used_;
+  used_ = 0;
+  write_all(fd_, static_cast<const char*>(static_cast<void*>(buffer_.data())),
+            size);
+}
+
+void output_sink::close() {
+  if (fd_ < 0) {
+    return;
+  }
+  if (map_ != nullptr) {
+    auto size = used_;
+    used_ = 0;
+    unmap();
+#if MULTIBASE_HAVE_POSIX_IO
+    if (::ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+      throw std::system_error{errno, std::generic_category(), "ftruncate"};
+    }
+#endif
+  } else {
+    flush();
+  }
+  if (owns_fd_) {
+#if MULTIBASE_HAVE_POSIX_IO
+    ::close(fd_);
+#else
+    ::_close(fd_);
+#endif
+    fd_ = -1;
+  }
+}
+
+void output_sink::discard() noexcept {
+  if (fd_ < 0) {
+    return;
+  }
+  used_ = 0;
+  unmap();
+  if (owns_fd_) {
+#if MULTIBASE_HAVE_POSIX_IO
+    ::close(fd_);
+#else
+    ::_close(fd_);
+#endif
+    fd_ = -1;
+    if (!filename_.empty()) {
+      std::remove(filename_.c_str());
+    }
+  }
+}
+
+void output_sink::map([[maybe_unused]] std::size_t size) {
+#if MULTIBASE_HAVE_POSIX_IO
+  unmap();
+  if (::ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+    throw std::system_error{errno, std::generic_category(), "ftruncate"};
+  }
+  auto* map =
+      ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (map == MAP_FAILED) {  // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+    throw std::system_error{errno, std::generic_category(), "mmap"};
+  }
+  map_ = static_cast<std::byte*>(map);
+  map_size_ = size;
+#endif
+}
+
+void output_sink::unmap() noexcept {
+#if MULTIBASE_HAVE_POSIX_IO
+  if (map_ != nullptr) {
+    ::munmap(map_, map_size_);
+  }
+#endif
+  map_ = nullptr;
+  map_size_ = 0;
+}
+
+}  // namespace multibase
@@ -0,0 +1,245 @@
+// Copyright 2023 Lockblox
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <multibase/run_stats.hpp>
+
+#include <algorithm>  // for max
+#include <array>      // for array
+#include <atomic>     // for atomic, memory_order_relaxed
+#include <cstdlib>    // for malloc, free, aligned_alloc
+#include <ctime>      // for clock, CLOCKS_PER_SEC
+#include <new>        // for bad_alloc, align_val_t
+
+#include <fmt/core.h>  // for format
+
+#include <multibase/portability.hpp>  // for MULTIBASE_HAVE_POSIX_IO
+
+#if MULTIBASE_HAVE_POSIX_IO
+#include <sys/resource.h>  // for getrusage, RUSAGE_SELF
+#endif
+
+namespace {
+
+/// Allocations of the threads given a slot, each slot on its own cache line
+struct alignas(64) allocation_slot {
+  std::atomic<std::uint64_t> count{0};
+};
+
+/// Threads beyond this many share the slots from the first again
+constexpr std::size_t slot_count = 64;
+
+std::array<allocation_slot, slot_count> allocation_slots{};
+std::atomic<std::size_t> next_slot{0};
+
+/// Count an allocation in the slot the calling thread claims on its first
+void count_allocation() noexcept {
+  thread_local auto& slot =
+      allocation_slots[next_slot.fetch_add(1, std::memory_order_relaxed) %
+                       slot_count];
+  slot.count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void* allocate(std::size_t size) {
+  count_allocation();
+  if (auto* ptr = std::malloc(size == 0 ? 1 : size)) {  // NOLINT
+    return ptr;
+  }
+  throw std::bad_alloc{};
+}
+
+}  // namespace
+
+// every allocation of the tool is counted, which costs an atomic increment
+// of a counter the thread seldom shares with another
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }  // NOLINT
+void operator delete[](void* ptr) noexcept { std::free(ptr); }  // NOLINT
+void operator delete(void* ptr, std::size_t /*size*/) noexcept {
+  std::free(ptr);  // NOLINT
+}
+void operator delete[](void* ptr, std::size_t /*size*/) noexcept {
+  std::free(ptr);  // NOLINT
+}
+
+#if MULTIBASE_HAVE_POSIX_IO
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  count_allocation();
+  const auto align = static_cast<std::size_t>(alignment);
+  // aligned_alloc wants a whole number of alignments
+  const auto rounded = (std::max(size, std::size_t{1}) + align - 1) / align *
+                       align;
+  if (auto* ptr = std::aligned_alloc(align, rounded)) {  // NOLINT
+    return ptr;
+  }
+  throw std::bad_alloc{};
+}
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+  return operator new(size, alignment);
+}
+void operator delete(void* ptr, std::align_val_t /*alignment*/) noexcept {
+  std::free(ptr);  // NOLINT
+}
+void operator delete[](void* ptr, std::align_val_t /*alignment*/) noexcept {
+  std::free(ptr);  // NOLINT
+}
+void operator delete(void* ptr, std::size_t /*size*/,
+                     std::align_val_t /*alignment*/) noexcept {
+  std::free(ptr);  // NOLINT
+}
+void operator delete[](void* ptr, std::size_t /*size*/,
+                       std::align_val_t /*alignment*/) noexcept {
+  std::free(ptr);  // NOLINT
+}
+#endif
+
+namespace multibase {
+
+namespace {
+
+using seconds = std::chrono::duration<double>;
+
+constexpr double bytes_per_megabyte = 1e6;
+constexpr double bytes_per_mebibyte = 1024.0 * 1024.0;
+
+struct cpu_time {
+  seconds user{};
+  seconds system{};
+  std::size_t peak_rss{0};
+};
+
+cpu_time cpu_usage() {
+  auto result = cpu_time{};
+#if MULTIBASE_HAVE_POSIX_IO
+  struct rusage usage {};
+  if (::getrusage(RUSAGE_SELF, &usage) == 0) {
+    auto to_seconds = [](const timeval& time) {
+      return seconds{static_cast<double>(time.tv_sec) +
+                     static_cast<double>(time.tv_usec) / 1e6};
+    };
+    result.user = to_seconds(usage.ru_utime);
+    result.system = to_seconds(usage.ru_stime);
+#if defined(__APPLE__)
+    result.peak_rss = static_cast<std::size_t>(usage.ru_maxrss);
+#else
+    // Linux reports kilobytes
+    constexpr std::size_t kilobyte = 1024;
+    result.peak_rss = static_cast<std::size_t>(usage.ru_maxrss) * kilobyte;
+#endif
+  }
+#else
+  result.user = seconds{static_cast<double>(std::clock()) / CLOCKS_PER_SEC};
+#endif
+  return result;
+}
+
+double megabytes_per_second(std::size_t bytes, seconds elapsed) {
+  return elapsed.count() > 0
+             ? static_cast<double>(bytes) / bytes_per_megabyte /
+                   elapsed.count()
+             : 0.0;
+}
+
+std::string json_string(std::string_view text) {
+  auto result = std::string{"\""};
+  for (auto chr : text) {
+    if (chr == '"' || chr == '\\') {
+      result += '\\';
+      result += chr;
+    } else if (static_cast<unsigned char>(chr) < ' ') {
+      result += fmt::format("\\u{:04x}", static_cast<unsigned>(chr));
+    } else {
+      result += chr;
+    }
+  }
+  return result + '"';
+}
+
+}  // namespace
+
+std::uint64_t allocation_count() noexcept {
+  auto result = std::uint64_t{0};
+  for (const auto& slot : allocation_slots) {
+    result += slot.count.load(std::memory_order_relaxed);
+  }
+  return result;
+}
+
+run_stats::run_stats()
+    : start_{clock::now()}, start_allocations_{allocation_count()} {
+  auto cpu = cpu_usage();
+  start_user_ = cpu.user;
+  start_system_ = cpu.system;
+}
+
+run_stats::usage run_stats::measure() const {
+  auto cpu = cpu_usage();
+  auto result = usage{};
+  result.wall = clock::now() - start_;
+  result.user = cpu.user - start_user_;
+  result.system = cpu.system - start_system_;
+  result.peak_rss = cpu.peak_rss;
+  result.allocations = allocation_count() - start_allocations_;
+  for (const auto& converted : files_) {
+    result.bytes_in += converted.bytes_in;
+    result.bytes_out += converted.bytes_out;
+  }
+  return result;
+}
+
+void run_stats::print(std::ostream& out, std::string_view kernel) const {
+  const auto total = measure();
+  out << fmt::format("{:>14} {:>14} {:>10} {:>10}  {}\n", "bytes in",
+                     "bytes out", "seconds", "MB/s", "file");
+  for (const auto& converted : files_) {
+    out << fmt::format(
+        "{:>14} {:>14} {:>10.4f} {:>10.1f}  {}\n", converted.bytes_in,
+        converted.bytes_out, converted.elapsed.count(),
+        megabytes_per_second(converted.bytes_in, converted.elapsed),
+        converted.name);
+  }
+  out << fmt::format("{:>14} {:>14} {:>10.4f} {:>10.1f}  total\n",
+                     total.bytes_in, total.bytes_out, total.wall.count(),
+                     megabytes_per_second(total.bytes_in, total.wall));
+  out << fmt::format(
+      "cpu {:.4f} s (user {:.4f} s, system {:.4f} s), kernel {}, peak RSS "
+      "{:.1f} MiB, {} allocations\n",
+      (total.user + total.system).count(), total.user.count(),
+      total.system.count(), kernel,
+      static_cast<double>(total.peak_rss) / bytes_per_mebibyte,
+      total.allocations);
+}
+
+void run_stats::print_json(std::ostream& out, std::string_view kernel) const {
+  const auto total = measure();
+  auto files = std::string{};
+  for (const auto& converted : files_) {
+    files += fmt::format(
+        "{}{{\"name\":{},\"bytes_in\":{},\"bytes_out\":{},\"seconds\":{},"
+        "\"mb_per_s\":{}}}",
+        files.empty() ? "" : ",", json_string(converted.name),
+        converted.bytes_in, converted.bytes_out, converted.elapsed.count(),
+        megabytes_per_second(converted.bytes_in, converted.elapsed));
+  }
+  out << fmt::format(
+      "{{\"files\":[{}],\"bytes_in\":{},\"bytes_out\":{},\"wall_seconds\":{},"
+      "\"user_seconds\":{},\"system_seconds\":{},\"mb_per_s\":{},"
+      "\"kernel\":{},\"peak_rss_bytes\":{},\"allocations\":{}}}\n",
+      files, total.bytes_in, total.bytes_out, total.wall.count(),
+      total.user.count(), total.system.count(),
+      megabytes_per_second(total.bytes_in, total.wall), json_string(kernel),
+      total.peak_rss, total.allocations);
+}
+
+}  // namespace multibase
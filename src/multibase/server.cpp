@@ -0,0 +1,339 @@
+// Copyright 2023 Lockblox
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <multibase/server.hpp>
+
+#include <algorithm>     // for copy
+#include <array>         // for array
+#include <cerrno>        // for errno, EINTR
+#include <cstdint>       // for uint64_t
+#include <exception>     // for exception
+#include <optional>      // for optional
+#include <semaphore>     // for counting_semaphore
+#include <span>          // for span, as_writable_bytes
+#include <stdexcept>     // for invalid_argument, runtime_error
+#include <string_view>   // for string_view
+#include <system_error>  // for system_error, generic_category
+#include <thread>        // for thread
+#include <vector>        // for vector
+
+#include <fmt/core.h>  // for format
+
+#include <magic_enum.hpp>  // for enum_count, enum_index
+
+#include <multibase/codec.hpp>        // for codec, decode, validate
+#include <multibase/encoding.hpp>     // for encoding
+#include <multibase/output_sink.hpp>  // for output_sink
+#include <multibase/portability.hpp>  // for MULTIBASE_HAVE_POSIX_IO
+#include <multibase/transcode.hpp>    // for transcoder
+
+#if MULTIBASE_HAVE_POSIX_IO
+#include <csignal>       // for signal, SIGPIPE
+#include <sys/socket.h>  // for socket, bind, listen, accept
+#include <sys/stat.h>    // for stat, S_ISSOCK
+#include <sys/un.h>      // for sockaddr_un
+#include <unistd.h>      // for read, close, unlink
+#endif
+
+namespace multibase {
+
+namespace {
+
+constexpr std::size_t length_size = 4;
+constexpr std::size_t byte_bits = 8;
+
+enum class status : char { success = 0, failure = 1 };
+
+std::string_view as_chars(std::span<const std::byte> bytes) {
+  return {static_cast<const char*>(static_cast<const void*>(bytes.data())),
+          bytes.size()};
+}
+
+std::size_t read_length(std::span<const std::byte> bytes) {
+  auto length = std::size_t{0};
+  for (auto byte : bytes.first(length_size)) {
+    length = (length << byte_bits) | static_cast<std::size_t>(byte);
+  }
+  return length;
+}
+
+void write_number(std::uint64_t number, std::span<char> space) {
+  for (auto it = space.rbegin(); it != space.rend(); ++it) {
+    *it = static_cast<char>(number & 0xFFU);
+    number >>= byte_bits;
+  }
+}
+
+/// Codecs and buffers kept warm from one request of a connection to the next
+class session {
+ public:
+  explicit session(output_sink& output) : output_{output} {}
+
+  /// Answer one request, reporting any failure in the response
+  void handle(std::span<const std::byte> request) {
+    try {
+      if (request.size() < 2) {
+        throw std::invalid_argument{"Request without operation or encoding"};
+      }
+      const auto code = static_cast<char>(request[1]);
+      const auto payload = request.subspan(2);
+      switch (static_cast<operation>(request[0])) {
+        case operation::encode:
+          return encode(multibase::decode(code), payload);
+        case operation::decode:
+          return decode(code, as_chars(payload));
+        case operation::transcode:
+          return transcode(multibase::decode(code), as_chars(payload));
+        case operation::validate:
+          return validate(code, as_chars(payload));
+      }
+      throw std::invalid_argument{fmt::format(
+          "Unknown operation {}", static_cast<char>(request[0]))};
+    } catch (const std::exception& error) {
+      auto message = std::string_view{error.what()};
+      auto space = begin(message.size());
+      std::ranges::copy(message, space.begin());
+      end(message.size(), status::failure);
+    }
+  }
+
+ private:
+  codec& codec_for(encoding base) {
+    auto& entry = codecs_.at(magic_enum::enum_index(base).value());
+    if (!entry) {
+      entry.emplace(base);
+    }
+    return *entry;
+  }
+
+  /// Prefix of the payload, which must match the requested encoding
+  static encoding prefix_of(char code, std::string_view payload) {
+    if (payload.empty()) {
+      throw std::invalid_argument{"Missing multibase prefix"};
+    }
+    auto base = multibase::decode(payload.front());
+    if (code != any_encoding && base != multibase::decode(code)) {
+      throw std::invalid_argument{
+          fmt::format("Expected encoding {} but found {}", code,
+                      payload.front())};
+    }
+    return base;
+  }
+
+  void encode(encoding base, std::span<const std::byte> payload) {
+    auto& encoder = codec_for(base);
+    auto size = encoder.encoded_size(payload.size());
+    auto space = begin(1 + size);
+    space.front() = multibase::encode(base);
+    auto body = space.subspan(1, size);
+    auto view = encoder.encode(payload, body);
+    if (view.data() != body.data()) {
+      std::ranges::copy(view, body.begin());
+    }
+    end(1 + view.size(), status::success);
+  }
+
+  void decode(char code, std::string_view payload) {
+    auto& decoder = codec_for(prefix_of(code, payload));
+    payload.remove_prefix(1);
+    auto size = decoder.decoded_size(payload);
+    auto space = std::as_writable_bytes(begin(size));
+    auto view = decoder.decode(payload, space);
+    if (view.data() != space.data()) {
+      std::ranges::copy(view, space.begin());
+    }
+    end(view.size(), status::success);
+  }
+
+  void transcode(encoding to, std::string_view payload) {
+    auto from = prefix_of(any_encoding, payload);
+    payload.remove_prefix(1);
+    if (!transcoder_ || from != from_ || to != to_) {
+      transcoder_.emplace(from, to);
+      from_ = from;
+      to_ = to;
+    }
+    auto size = transcoder_->transcoded_size(payload);
+    auto space = begin(1 + size);
+    space.front() = multibase::encode(to);
+    auto view = transcoder_->transcode(payload, space.subspan(1, size));
+    end(1 + view.size(), status::success);
+  }
+
+  void validate(char code, std::string_view payload) {
+    auto base = std::optional<encoding>{};
+    if (code != any_encoding) {
+      base = multibase::decode(code);
+    }
+    auto result = multibase::validate(payload, base);
+    if (!result) {
+      throw std::invalid_argument{fmt::format("Invalid input at offset {}",
+                                              result.error_offset.value())};
+    }
+    constexpr auto number_size = sizeof(std::uint64_t);
+    write_number(result.decoded_size, begin(number_size).first(number_size));
+    end(number_size, status::success);
+  }
+
+  /// Space for a response body of at most size bytes after its status
+  std::span<char> begin(std::size_t size) {
+    if (size >= max_frame_size) {
+      throw std::invalid_argument{
+          fmt::format("Response of {} bytes is too large", size)};
+    }
+    response_ = output_.prepare(length_size + 1 + size);
+    return response_.subspan(length_size + 1, size);
+  }
+
+  /// Complete the response begun last with a body of size bytes
+  void end(std::size_t size, status result) {
+    write_number(size + 1, response_.first(length_size));
+    response_[length_size] = static_cast<char>(result);
+    output_.commit(length_size + 1 + size);
+  }
+
+  output_sink& output_;
+  std::span<char> response_;
+  std::array<std::optional<codec>, magic_enum::enum_count<encoding>()>
+      codecs_;
+  std::optional<transcoder> transcoder_;
+  encoding from_{encoding::base_none};
+  encoding to_{encoding::base_none};
+};
+
+#if MULTIBASE_HAVE_POSIX_IO
+/// Read whatever is available, without waiting to fill the buffer
+std::size_t read_some(int descriptor, std::span<std::byte> buffer) {
+  for (;;) {
+    auto count = ::read(descriptor, buffer.data(), buffer.size());
+    if (count >= 0) {
+      return static_cast<std::size_t>(count);
+    }
+    if (errno != EINTR) {
+      throw std::system_error{errno, std::generic_category(), "read"};
+    }
+  }
+}
+#endif
+
+}  // namespace
+
+void serve([[maybe_unused]] int input, [[maybe_unused]] int output) {
+#if MULTIBASE_HAVE_POSIX_IO
+  auto sink = output_sink{output};
+  auto connection = session{sink};
+  auto buffer = std::vector<std::byte>(output_sink::block_size);
+  auto first = std::size_t{0};
+  auto last = std::size_t{0};
+  for (;;) {
+    // answer every complete request already read
+    auto needed = length_size;
+    while (last - first >= length_size) {
+      auto length = read_length(std::span{buffer}.subspan(first));
+      if (length > max_frame_size) {
+        throw std::invalid_argument{
+            fmt::format("Request of {} bytes is too large", length)};
+      }
+      needed = length_size + length;
+      if (last - first < needed) {
+        break;
+      }
+      connection.handle(
+          std::span{buffer}.subspan(first + length_size, length));
+      first += needed;
+      needed = length_size;
+    }
+    // send the answers before waiting for more requests
+    sink.flush();
+    std::copy(std::next(buffer.begin(), static_cast<std::ptrdiff_t>(first)),
+              std::next(buffer.begin(), static_cast<std::ptrdiff_t>(last)),
+              buffer.begin());
+    last -= first;
+    first = 0;
+    if (buffer.size() < needed) {
+      buffer.resize(needed);
+    }
+    auto count = read_some(input, std::span{buffer}.subspan(last));
+    if (count == 0) {
+      return;
+    }
+    last += count;
+  }
+#else
+  throw std::runtime_error{"Serving is not supported on this platform"};
+#endif
+}
+
+void serve_socket([[maybe_unused]] const std::string& path) {
+#if MULTIBASE_HAVE_POSIX_IO
+  auto address = sockaddr_un{};
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) {
+    throw std::invalid_argument{fmt::format("Socket path too long: {}", path)};
+  }
+  std::ranges::copy(path, std::begin(address.sun_path));
+  // a socket left behind by an earlier server is replaced
+  struct stat info {};
+  if (::stat(path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode)) {
+    ::unlink(path.c_str());
+  }
+  auto listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener < 0) {
+    throw std::system_error{errno, std::generic_category(), "socket"};
+  }
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  if (::bind(listener, reinterpret_cast<const sockaddr*>(&address),
+             sizeof(address)) != 0 ||
+      ::listen(listener, SOMAXCONN) != 0) {
+    auto error = errno;
+    ::close(listener);
+    throw std::system_error{error, std::generic_category(), path};
+  }
+  // a client going away is reported by write rather than by a signal
+  std::signal(SIGPIPE, SIG_IGN);  // NOLINT(cert-err33-c)
+  // a connection takes a slot for as long as it is served, and clients
+  // beyond the limit wait in the listen backlog until one is free
+  auto slots = std::counting_semaphore<max_connections>{max_connections};
+  for (;;) {
+    slots.acquire();
+    auto client = ::accept(listener, nullptr, nullptr);
+    if (client < 0) {
+      auto error = errno;
+      slots.release();
+      if (error == EINTR || error == ECONNABORTED) {
+        continue;
+      }
+      ::close(listener);
+      // the connections still served use the slots, so they end first
+      for (auto slot = std::ptrdiff_t{0}; slot < max_connections; ++slot) {
+        slots.acquire();
+      }
+      throw std::system_error{error, std::generic_category(), "accept"};
+    }
+    std::thread{[client, &slots]() {
+      try {
+        serve(client, client);
+      } catch (...) {  // NOLINT(bugprone-empty-catch)
+        // a broken connection only ends its own session
+      }
+      ::close(client);
+      slots.release();
+    }}.detach();
+  }
+#else
+  throw std::runtime_error{"Serving is not supported on this platform"};
+#endif
+}
+
+}  // namespace multibase
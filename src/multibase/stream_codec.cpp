@@ -0,0 +1,511 @@
+// Copyright 2023 Lockblox
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <multibase/stream_codec.hpp>
+
+#include <algorithm>           // for min, max, copy
+#include <condition_variable>  // for condition_variable
+#include <exception>           // for exception_ptr, rethrow_exception
+#include <functional>          // for function
+#include <mutex>               // for mutex, unique_lock, lock_guard
+#include <span>                // for span, as_writable_bytes
+#include <stdexcept>           // for invalid_argument
+#include <string>              // for string
+#include <string_view>         // for string_view
+#include <thread>              // for jthread
+#include <vector>              // for vector
+
+#include <fmt/core.h>  // for format
+
+#include <multibase/codec.hpp>              // for codec, encode, decode
+#include <multibase/encoding_metadata.hpp>  // for encoding_metadata
+#include <multibase/transcode.hpp>          // for transcoder
+#include <multibase/tuning.hpp>             // for active_tuning
+
+namespace multibase {
+
+namespace {
+
+std::string_view as_chars(std::span<const std::byte> bytes) {
+  return {static_cast<const char*>(static_cast<const void*>(bytes.data())),
+          bytes.size()};
+}
+
+/// Pass the input to the kernel in whole groups of granule bytes, carrying an
+/// incomplete group over from one block to the next. Large blocks are cut
+/// into slices to bound the output buffered by each call.
+template <typename Kernel>
+void for_each_block(input_source& input, std::span<const std::byte> block,
+                    std::size_t granule, std::size_t threads, Kernel kernel) {
+  const auto slice_size =
+      threads > 1 ? threads * active_tuning().segment_size
+                  : input_source::block_size;
+  const auto slice = std::max(granule, slice_size / granule * granule);
+  auto carry = std::vector<std::byte>{};
+  carry.reserve(granule);
+  for (; !block.empty(); block = input.next()) {
+    if (!carry.empty()) {
+      auto count = std::min(granule - carry.size(), block.size());
+      auto head = block.first(count);
+      carry.insert(carry.end(), head.begin(), head.end());
+      block = block.subspan(count);
+      if (carry.size() < granule) {
+        continue;
+      }
+      kernel(std::span<const std::byte>{carry});
+      carry.clear();
+    }
+    while (block.size() >= granule) {
+      auto size = std::min(slice, block.size() / granule * granule);
+      kernel(block.first(size));
+      block = block.subspan(size);
+    }
+    carry.assign(block.begin(), block.end());
+  }
+  if (!carry.empty()) {
+    kernel(std::span<const std::byte>{carry});
+  }
+}
+
+/// Run the kernel once over the whole of the input, of which the first block
+/// has already been read
+template <typename Kernel>
+void for_all(input_source& input, std::span<const std::byte> block,
+             Kernel kernel) {
+  if (auto remaining = input.size(); remaining && *remaining == 0) {
+    kernel(block);
+    return;
+  }
+  auto contents = std::vector<std::byte>{block.begin(), block.end()};
+  auto rest = input.read_all();
+  contents.insert(contents.end(), rest.begin(), rest.end());
+  kernel(std::span<const std::byte>{contents});
+}
+
+/// Threads which share the segments of each block of a stream with the
+/// thread converting it. They start with the first block which is split,
+/// and are reused for every block after it.
+class segment_workers {
+ public:
+  /// @param threads Number of threads converting a block, including the
+  /// caller
+  explicit segment_workers(std::size_t threads)
+      : count_{std::max<std::size_t>(threads, 1) - 1} {}
+  segment_workers(const segment_workers&) = delete;
+  segment_workers(segment_workers&&) = delete;
+  segment_workers& operator=(const segment_workers&) = delete;
+  segment_workers& operator=(segment_workers&&) = delete;
+  ~segment_workers() {
+    {
+      auto lock = std::lock_guard{mutex_};
+      is_stopping_ = true;
+    }
+    posted_.notify_all();
+  }
+
+  /// Call task, which must not throw, with each index in [0, size) on the
+  /// workers and the calling thread, returning once every call has returned
+  void run(std::size_t size, const std::function<void(std::size_t)>& task) {
+    if (threads_.empty()) {
+      threads_.reserve(count_);
+      for (std::size_t i = 0; i < count_; ++i) {
+        threads_.emplace_back([this]() { serve(); });
+      }
+    }
+    {
+      auto lock = std::lock_guard{mutex_};
+      task_ = &task;
+      next_ = 0;
+      size_ = size;
+      remaining_ = size;
+    }
+    posted_.notify_all();
+    work();
+    auto lock = std::unique_lock{mutex_};
+    finished_.wait(lock, [this]() { return remaining_ == 0; });
+    task_ = nullptr;
+  }
+
+ private:
+  /// Run tasks until every index has been claimed
+  void work() {
+    for (;;) {
+      auto index = std::size_t{0};
+      const std::function<void(std::size_t)>* task = nullptr;
+      {
+        auto lock = std::lock_guard{mutex_};
+        if (next_ == size_) {
+          return;
+        }
+        index = next_++;
+        task = task_;
+      }
+      (*task)(index);
+      auto is_finished = false;
+      {
+        auto lock = std::lock_guard{mutex_};
+        is_finished = --remaining_ == 0;
+      }
+      if (is_finished) {
+        finished_.notify_one();
+      }
+    }
+  }
+
+  void serve() {
+    for (;;) {
+      {
+        auto lock = std::unique_lock{mutex_};
+        posted_.wait(lock, [this]() { return is_stopping_ || next_ < size_; });
+        if (is_stopping_) {
+          return;
+        }
+      }
+      work();
+    }
+  }
+
+  std::size_t count_;
+  std::mutex mutex_;
+  std::condition_variable posted_;
+  std::condition_variable finished_;
+  const std::function<void(std::size_t)>* task_{nullptr};
+  std::size_t next_{0};
+  std::size_t size_{0};
+  std::size_t remaining_{0};
+  bool is_stopping_{false};
+  // joined before the state they share is destroyed
+  std::vector<std::jthread> threads_;
+};
+
+/// Part of a block converted by one thread
+struct segment {
+  std::span<const std::byte> input;
+  std::span<char> output;
+  std::size_t written{0};
+  std::exception_ptr error;
+};
+
+/** Convert a block into the output sink, splitting it between the workers in
+ whole groups of granule bytes when there is enough of it. Each thread
+ writes straight to the offset of its segment in the output.
+ @param size_of Exact size of the output of all but the last segment
+ @param convert Convert a segment into the given space, returning the number
+ of characters written
+ @return whether the output fell short of its size, as it does when the end
+ of the block is padded */
+template <typename Size, typename Convert>
+bool convert_block(output_sink& output, std::span<const std::byte> block,
+                   std::size_t granule, std::size_t threads,
+                   segment_workers& workers, Size size_of, Convert convert) {
+  auto groups = block.size() / granule;
+  const auto min_size =
+      std::max<std::size_t>(active_tuning().parallel_min_size, 1);
+  auto parts = std::min(threads, block.size() / min_size);
+  if (parts <= 1) {
+    auto size = size_of(block);
+    auto written = convert(block, output.prepare(size).first(size));
+    output.commit(written);
+    return written < size;
+  }
+  auto part_size = (groups + parts - 1) / parts * granule;
+  auto segments = std::vector<segment>{};
+  auto sizes = std::vector<std::size_t>{};
+  auto total = std::size_t{0};
+  for (auto rest = block; !rest.empty();) {
+    auto input = rest.first(std::min(part_size, rest.size()));
+    rest = rest.subspan(input.size());
+    segments.push_back(segment{input, {}, 0, nullptr});
+    sizes.push_back(size_of(input));
+    total += sizes.back();
+  }
+  auto space = output.prepare(total).first(total);
+  for (std::size_t i = 0; i < segments.size(); ++i) {
+    segments[i].output = space.first(sizes[i]);
+    space = space.subspan(sizes[i]);
+  }
+
+  workers.run(segments.size(), [&](std::size_t index) noexcept {
+    auto& part = segments[index];
+    try {
+      part.written = convert(part.input, part.output);
+    } catch (...) {
+      part.error = std::current_exception();
+    }
+  });
+
+  for (const auto& part : segments) {
+    if (part.error) {
+      std::rethrow_exception(part.error);
+    }
+  }
+  for (std::size_t i = 0; i + 1 < segments.size(); ++i) {
+    if (segments[i].written != segments[i].output.size()) {
+      throw std::invalid_argument{"Padding before the end of the input"};
+    }
+  }
+  const auto& last = segments.back();
+  output.commit(total - last.output.size() + last.written);
+  return last.written < last.output.size();
+}
+
+/// Call the visitor with each record of the input, without its delimiter.
+/// Records lying within a block are passed in place, others are gathered in
+/// a buffer which is reused from one record to the next.
+template <typename Visitor>
+void for_each_record(input_source& input, char delimiter, Visitor visit) {
+  auto carry = std::string{};
+  for (auto block = as_chars(input.next()); !block.empty();
+       block = as_chars(input.next())) {
+    for (auto end = block.find(delimiter); end != std::string_view::npos;
+         end = block.find(delimiter)) {
+      if (carry.empty()) {
+        visit(block.substr(0, end));
+      } else {
+        carry.append(block.substr(0, end));
+        visit(std::string_view{carry});
+        carry.clear();
+      }
+      block.remove_prefix(end + 1);
+    }
+    carry.append(block);
+  }
+  if (!carry.empty()) {
+    visit(std::string_view{carry});
+  }
+}
+
+/// Encoded record without the carriage return of a CRLF line ending, which is
+/// not a character of any encoding but the identity
+std::string_view without_carriage_return(std::string_view record,
+                                         char delimiter, encoding base) {
+  if (delimiter == '\n' && base != encoding::base_none &&
+      record.ends_with('\r')) {
+    record.remove_suffix(1);
+  }
+  return record;
+}
+
+}  // namespace
+
+void encode_stream(input_source& input, output_sink& output, encoding base,
+                   bool multiformat, std::size_t threads) {
+  if (multiformat) {
+    const auto prefix = encode(base);
+    output.write(std::string_view{&prefix, 1});
+  }
+  if (base == encoding::base_none) {
+    input.transfer_to(output);
+    return;
+  }
+  auto encoder = codec{base};
+  auto encoded_size = [&encoder](std::span<const std::byte> block) {
+    return encoder.encoded_size(block.size());
+  };
+  auto encode_segment = [&encoder](std::span<const std::byte> block,
+                                   std::span<char> space) {
+    auto view = encoder.encode(block, space);
+    if (view.data() != space.data()) {
+      std::ranges::copy(view, space.begin());
+    }
+    return view.size();
+  };
+  auto workers = segment_workers{threads};
+  if (auto granule = encoder.decoded_chunk_size()) {
+    for_each_block(input, input.next(), *granule, threads,
+                   [&](std::span<const std::byte> block) {
+                     convert_block(output, block, *granule, threads, workers,
+                                   encoded_size, encode_segment);
+                   });
+  } else {
+    convert_block(output, input.read_all(), 1, 1, workers, encoded_size,
+                  encode_segment);
+  }
+}
+
+void decode_stream(input_source& input, output_sink& output,
+                   std::optional<encoding> base, std::size_t threads) {
+  auto block = input.next();
+  if (!base) {
+    if (block.empty()) {
+      throw std::invalid_argument{"Missing multibase prefix"};
+    }
+    base = decode(static_cast<char>(block.front()));
+    block = block.subspan(1);
+  }
+  if (*base == encoding::base_none) {
+    output.write(block);
+    input.transfer_to(output);
+    return;
+  }
+  auto decoder = codec{*base};
+  auto decoded_size = [&decoder](std::span<const std::byte> chunk) {
+    return decoder.decoded_size(as_chars(chunk));
+  };
+  auto decode_segment = [&decoder](std::span<const std::byte> chunk,
+                                   std::span<char> chars) {
+    auto space = std::as_writable_bytes(chars);
+    auto view = decoder.decode(as_chars(chunk), space);
+    if (view.data() != space.data()) {
+      std::ranges::copy(view, space.begin());
+    }
+    return view.size();
+  };
+  auto workers = segment_workers{threads};
+  if (auto granule = decoder.encoded_chunk_size()) {
+    // padding ends the input, wherever the blocks happen to be cut
+    auto is_padded = false;
+    for_each_block(input, block, *granule, threads,
+                   [&](std::span<const std::byte> chunk) {
+                     if (is_padded) {
+                       throw std::invalid_argument{
+                           "Padding before the end of the input"};
+                     }
+                     is_padded = convert_block(output, chunk, *granule,
+                                               threads, workers, decoded_size,
+                                               decode_segment);
+                   });
+  } else {
+    for_all(input, block, [&](std::span<const std::byte> chunk) {
+      convert_block(output, chunk, 1, 1, workers, decoded_size,
+                    decode_segment);
+    });
+  }
+}
+
+void transcode_stream(input_source& input, output_sink& output, encoding to,
+                      std::optional<encoding> from, bool multiformat) {
+  auto block = input.next();
+  if (!from) {
+    if (block.empty()) {
+      throw std::invalid_argument{"Missing multibase prefix"};
+    }
+    from = decode(static_cast<char>(block.front()));
+    block = block.subspan(1);
+  }
+  if (multiformat) {
+    const auto prefix = encode(to);
+    output.write(std::string_view{&prefix, 1});
+  }
+  auto converter = transcoder{*from, to};
+  // each block is transcoded on its own, so padding at the end of one which
+  // is not the last is caught here
+  const auto padding = encoding_metadata{*from}.padding();
+  auto is_padded = false;
+  auto transcode_block = [&](std::span<const std::byte> chunk) {
+    if (is_padded) {
+      throw std::invalid_argument{"Padding before the end of the input"};
+    }
+    auto chars = as_chars(chunk);
+    is_padded = padding != 0 && chars.ends_with(padding);
+    auto size = converter.transcoded_size(chars);
+    auto view = converter.transcode(chars, output.prepare(size).first(size));
+    output.commit(view.size());
+  };
+  if (auto granule = converter.chunk_size()) {
+    for_each_block(input, block, *granule, 1, transcode_block);
+  } else {
+    for_all(input, block, transcode_block);
+  }
+}
+
+void encode_records(input_source& input, output_sink& output, encoding base,
+                    char delimiter, bool multiformat) {
+  auto encoder = codec{base};
+  const auto prefix = encode(base);
+  const auto offset = multiformat ? std::size_t{1} : std::size_t{0};
+  for_each_record(input, delimiter, [&](std::string_view record) {
+    auto size = encoder.encoded_size(record.size());
+    // room for the prefix, the encoded record and its delimiter
+    auto space = output.prepare(offset + size + 1);
+    space.front() = prefix;
+    auto body = space.subspan(offset, size);
+    auto view = encoder.encode(std::as_bytes(std::span{record}), body);
+    if (view.data() != body.data()) {
+      std::ranges::copy(view, body.begin());
+    }
+    space[offset + view.size()] = delimiter;
+    output.commit(offset + view.size() + 1);
+  });
+}
+
+void decode_records(input_source& input, output_sink& output, char delimiter,
+                    std::optional<encoding> base) {
+  auto current = base.value_or(encoding::base_none);
+  auto decoder = codec{current};
+  auto count = std::size_t{0};
+  for_each_record(input, delimiter, [&](std::string_view record) {
+    ++count;
+    try {
+      if (!base && !record.empty()) {
+        auto prefixed = decode(record.front());
+        if (prefixed != current) {
+          current = prefixed;
+          decoder = codec{current};
+        }
+        record.remove_prefix(1);
+      }
+      record = without_carriage_return(record, delimiter, current);
+      auto size = decoder.decoded_size(record);
+      // room for the decoded record and its delimiter
+      auto space = std::as_writable_bytes(output.prepare(size + 1));
+      auto body = space.first(size);
+      auto view = decoder.decode(record, body);
+      if (view.data() != body.data()) {
+        std::ranges::copy(view, body.begin());
+      }
+      space[view.size()] = static_cast<std::byte>(delimiter);
+      output.commit(view.size() + 1);
+    } catch (const std::invalid_argument& error) {
+      throw std::invalid_argument{
+          fmt::format("Record {}: {}", count, error.what())};
+    }
+  });
+}
+
+void transcode_records(input_source& input, output_sink& output, encoding to,
+                       char delimiter, std::optional<encoding> from,
+                       bool multiformat) {
+  auto current = from.value_or(to);
+  auto converter = transcoder{current, to};
+  const auto prefix = encode(to);
+  const auto offset = multiformat ? std::size_t{1} : std::size_t{0};
+  auto count = std::size_t{0};
+  for_each_record(input, delimiter, [&](std::string_view record) {
+    ++count;
+    try {
+      if (!from && !record.empty()) {
+        auto prefixed = decode(record.front());
+        if (prefixed != current) {
+          current = prefixed;
+          converter = transcoder{current, to};
+        }
+        record.remove_prefix(1);
+      }
+      record = without_carriage_return(record, delimiter, current);
+      auto size = converter.transcoded_size(record);
+      // room for the prefix, the converted record and its delimiter
+      auto space = output.prepare(offset + size + 1);
+      space.front() = prefix;
+      auto view = converter.transcode(record, space.subspan(offset, size));
+      space[offset + view.size()] = delimiter;
+      output.commit(offset + view.size() + 1);
+    } catch (const std::invalid_argument& error) {
+      throw std::invalid_argument{
+          fmt::format("Record {}: {}", count, error.what())};
+    }
+  });
+}
+
+}  // namespace multibase
@@ -0,0 +1,285 @@
+// Copyright 2023 Lockblox
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <multibase/swar_kernels.hpp>
+
+#include <algorithm>  // for min
+#include <array>      // for array
+#include <bit>        // for endian
+#include <cstdint>    // for uint64_t
+#include <cstring>    // for memcpy
+#include <stdexcept>  // for invalid_argument
+#include <utility>    // for index_sequence
+
+#include <multibase/basic_algorithm.hpp>  // for basic_algorithm
+#include <multibase/decode_table.hpp>     // for decode_table
+#include <multibase/encoding_traits.hpp>  // for encoding_traits
+#include <multibase/instrumentation.hpp>  // for call
+
+namespace multibase::swar {
+
+namespace {
+
+using word = std::uint64_t;
+
+constexpr std::size_t word_size = sizeof(word);
+constexpr unsigned byte_bits = 8;
+
+/// Each byte of a word set to value
+constexpr word repeat(unsigned char value) {
+  return word{value} * word{0x0101010101010101};
+}
+
+constexpr word high_bits = repeat(0x80);
+
+/// Value repeated in each lane of width bits
+constexpr word lanes(word value, unsigned width) {
+  auto result = word{0};
+  for (auto shift = 0U; shift < 64; shift += width) {
+    result |= value << shift;
+  }
+  return result;
+}
+
+/// Bits per character, which is also the bytes converted to or from eight
+/// characters
+template <encoding T>
+constexpr unsigned bits = encoding_traits<T>::alphabet.size() == 64   ? 6
+                          : encoding_traits<T>::alphabet.size() == 32 ? 5
+                                                                      : 4;
+
+/// Every pair of characters, indexed by the bits they encode
+template <encoding T>
+constexpr auto make_pairs() {
+  constexpr auto& alphabet = encoding_traits<T>::alphabet;
+  constexpr auto size = std::size_t{1} << 2 * bits<T>;
+  auto result = std::array<std::array<char, 2>, size>{};
+  for (std::size_t i = 0; i < result.size(); ++i) {
+    result.at(i) = {alphabet.at(i >> bits<T>),
+                    alphabet.at(i % alphabet.size())};
+  }
+  return result;
+}
+
+template <encoding T>
+constexpr auto pairs = make_pairs<T>();
+
+/// Write the pair of characters encoding the low bits of value
+template <encoding T>
+void put_pair(word value, char* output) {
+  constexpr auto mask = (word{1} << 2 * bits<T>) - 1;
+  const auto& pair = pairs<T>[static_cast<std::size_t>(value & mask)];
+  std::memcpy(output, pair.data(), pair.size());
+}
+
+constexpr word byteswap(word value) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_bswap64(value);
+#else
+  auto result = word{0};
+  for (std::size_t i = 0; i < word_size; ++i) {
+    result = (result << byte_bits) | (value & 0xff);
+    value >>= byte_bits;
+  }
+  return result;
+#endif
+}
+
+/// Word of the eight bytes at data, the first in the low bits
+word load_little(const void* data) {
+  auto result = word{0};
+  std::memcpy(&result, data, word_size);
+  if constexpr (std::endian::native == std::endian::big) {
+    result = byteswap(result);
+  }
+  return result;
+}
+
+/// Word of the eight bytes at data, the first in the high bits
+word load_big(const void* data) {
+  auto result = word{0};
+  std::memcpy(&result, data, word_size);
+  if constexpr (std::endian::native == std::endian::little) {
+    result = byteswap(result);
+  }
+  return result;
+}
+
+/// Store the high size bytes of value, the most significant first
+void store_big(word value, void* data, std::size_t size) {
+  if constexpr (std::endian::native == std::endian::little) {
+    value = byteswap(value);
+  }
+  std::memcpy(data, &value, size);
+}
+
+/// Whether each byte of value, all below 0x80, lies in [low, high], as its
+/// top bit
+constexpr word in_range(word value, unsigned char low, unsigned char high) {
+  const auto at_least = value + repeat(static_cast<unsigned char>(0x80 - low));
+  const auto above = value + repeat(static_cast<unsigned char>(0x7f - high));
+  return at_least & ~above & high_bits;
+}
+
+/// Values of eight hexadecimal digits, either case, in the matching bytes,
+/// or the top bit set in any byte when one is not a digit
+constexpr word translate_hex(word chars) {
+  if ((chars & high_bits) != 0) {
+    return high_bits;
+  }
+  // lower the case of letters alone, leaving other characters out of range
+  const auto letters = chars & repeat(0x40);
+  const auto folded = chars | (letters >> 1U);
+  const auto valid =
+      in_range(folded, '0', '9') | in_range(folded, 'a', 'f');
+  if (valid != high_bits) {
+    return high_bits;
+  }
+  return (folded & repeat(0x0f)) + (letters >> 6U) * 9;
+}
+
+/// Values of eight characters in the matching bytes, with the top bit set on
+/// those outside the alphabet, padding included
+template <encoding T>
+constexpr word translate(word chars) {
+  if constexpr (bits<T> == 4) {
+    return translate_hex(chars);
+  } else {
+    // unrolled, so that each byte is taken with a constant shift
+    return [chars]<std::size_t... i>(std::index_sequence<i...>) {
+      constexpr auto& table = decode_table<T>;
+      return ((word{table[static_cast<unsigned char>(chars >> i * byte_bits)]}
+               << i * byte_bits) |
+              ...);
+    }(std::make_index_sequence<word_size>{});
+  }
+}
+
+/// Whether translate_hex agrees with the decode table of T
+template <encoding T>
+constexpr bool matches_table() {
+  for (unsigned chr = 0; chr <= 0xff; ++chr) {
+    const auto value = translate<T>(repeat(static_cast<unsigned char>(chr)));
+    const auto expected = decode_table<T>.at(chr);
+    if ((value & high_bits) != 0 ? expected != invalid_value
+                                 : value != repeat(expected)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static_assert(matches_table<encoding::base_16>());
+static_assert(matches_table<encoding::base_16_upper>());
+
+/// Combine the values in the bytes of a word, the first highest, into the
+/// low 8 * bits bits
+template <encoding T>
+constexpr word pack(word values) {
+  constexpr auto field = bits<T>;
+  constexpr auto pair_mask = lanes((word{1} << field) - 1, 16);
+  values = ((values & pair_mask) << field) | ((values >> 8U) & pair_mask);
+  constexpr auto quad_mask = lanes((word{1} << 2 * field) - 1, 32);
+  values = ((values & quad_mask) << 2 * field) | ((values >> 16U) & quad_mask);
+  constexpr auto half_mask = (word{1} << 4 * field) - 1;
+  return ((values & half_mask) << 4 * field) | ((values >> 32U) & half_mask);
+}
+
+}  // namespace
+
+template <encoding T>
+std::string_view encode(std::span<const std::byte> input,
+                        std::span<char> output) {
+  auto measured = instrumentation::call{T, instrumentation::operation::encode,
+                                        input.size()};
+  constexpr auto step = std::size_t{bits<T>};
+  constexpr auto pair_bits = 2 * bits<T>;
+  const auto size =
+      encoding_traits<T>::padding != 0
+          ? basic_algorithm<T>::encoded_size(input.size())
+          : (input.size() * byte_bits + bits<T> - 1) / bits<T>;
+  // too small an output is left for the portable implementation to report
+  auto blocks = output.size() < size || input.size() < word_size
+                    ? 0
+                    : (input.size() - word_size) / step + 1;
+  const auto* in = input.data();
+  auto* out = output.data();
+  for (auto i = std::size_t{0}; i < blocks; ++i) {
+    const auto value = load_big(in);
+    put_pair<T>(value >> (64 - pair_bits), out);
+    put_pair<T>(value >> (64 - 2 * pair_bits), out + 2);
+    put_pair<T>(value >> (64 - 3 * pair_bits), out + 4);
+    put_pair<T>(value >> (64 - 4 * pair_bits), out + 6);
+    in += step;
+    out += word_size;
+  }
+  const auto written = blocks * word_size;
+  const auto tail = basic_algorithm<T>::encode(input.subspan(blocks * step),
+                                               output.subspan(written));
+  return measured.finish(
+      std::string_view{output.data(), written + tail.size()});
+}
+
+template <encoding T>
+std::span<std::byte> decode(std::string_view input,
+                            std::span<std::byte> output) {
+  auto measured = instrumentation::call{T, instrumentation::operation::decode,
+                                        input.size()};
+  constexpr auto step = std::size_t{bits<T>};
+  // the portable implementation takes the rest of the input from the first
+  // eight characters which are not plain alphabet or would overrun the output
+  const auto limit = std::min(input.size() / word_size, output.size() / step);
+  auto blocks = std::size_t{0};
+  for (; blocks < limit; ++blocks) {
+    const auto values = translate<T>(load_little(&input[blocks * word_size]));
+    if ((values & high_bits) != 0) {
+      break;
+    }
+    store_big(pack<T>(values) << (64 - byte_bits * step),
+              &output[blocks * step], step);
+  }
+  const auto written = blocks * step;
+  try {
+    const auto tail = basic_algorithm<T>::decode(
+        input.substr(blocks * word_size), output.subspan(written));
+    return measured.finish(std::span{output.data(), written + tail.size()});
+  } catch (const std::invalid_argument&) {
+    // report the error as it would be for the whole input
+    return measured.finish(basic_algorithm<T>::decode(input, output));
+  }
+}
+
+#define MULTIBASE_SWAR_KERNEL(base)                                         \
+  template std::string_view encode<encoding::base>(                         \
+      std::span<const std::byte>, std::span<char>);                         \
+  template std::span<std::byte> decode<encoding::base>(std::string_view,    \
+                                                       std::span<std::byte>)
+
+MULTIBASE_SWAR_KERNEL(base_16);
+MULTIBASE_SWAR_KERNEL(base_16_upper);
+MULTIBASE_SWAR_KERNEL(base_32);
+MULTIBASE_SWAR_KERNEL(base_32_upper);
+MULTIBASE_SWAR_KERNEL(base_32_pad);
+MULTIBASE_SWAR_KERNEL(base_32_pad_upper);
+MULTIBASE_SWAR_KERNEL(base_32_hex);
+MULTIBASE_SWAR_KERNEL(base_32_hex_upper);
+MULTIBASE_SWAR_KERNEL(base_32_hex_pad);
+MULTIBASE_SWAR_KERNEL(base_32_hex_pad_upper);
+MULTIBASE_SWAR_KERNEL(base_32_z);
+MULTIBASE_SWAR_KERNEL(base_64);
+MULTIBASE_SWAR_KERNEL(base_64_pad);
+MULTIBASE_SWAR_KERNEL(base_64_url);
+MULTIBASE_SWAR_KERNEL(base_64_url_pad);
+
+}  // namespace multibase::swar
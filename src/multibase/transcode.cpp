@@ -0,0 +1,339 @@
+// Copyright 2023 Lockblox
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <multibase/transcode.hpp>
+
+#include <algorithm>    // for copy, equal, fill
+#include <array>        // for array
+#include <bit>          // for countr_zero, has_single_bit
+#include <cstdint>      // for uint64_t
+#include <numeric>      // for lcm
+#include <stdexcept>    // for invalid_argument
+#include <string_view>  // for string_view
+#include <utility>      // for index_sequence
+
+#include <fmt/core.h>  // for format
+
+#include <magic_enum.hpp>  // for enum_values, enum_count, enum_index
+
+#include <multibase/decode_table.hpp>     // for decode_table, to_lower
+#include <multibase/encoding_case.hpp>    // for encoding_case
+#include <multibase/encoding_traits.hpp>  // for encoding_traits
+#include <multibase/portability.hpp>      // for MULTIBASE_HAVE_SSE2
+
+#if MULTIBASE_HAVE_SSE2
+#include <emmintrin.h>  // for _mm_cmplt_epi8, _mm_xor_si128
+#endif
+
+namespace multibase {
+
+namespace {
+
+constexpr std::size_t byte_bits = 8;
+
+/// What bit regrouping and case conversion need to know of an encoding
+struct alphabet {
+  std::string_view symbols;
+  const decode_table_type* values{nullptr};
+  /// Bits per character, or zero if the radix is not a power of two
+  std::size_t bits{0};
+  char padding{0};
+  encoding_case type_case{encoding_case::none};
+};
+
+template <encoding T>
+constexpr alphabet make_alphabet() {
+  if constexpr (T == encoding::base_none) {
+    return alphabet{};
+  } else {
+    using traits = encoding_traits<T>;
+    constexpr auto radix = traits::alphabet.size();
+    constexpr auto bits =
+        std::has_single_bit(radix)
+            ? static_cast<std::size_t>(std::countr_zero(radix))
+            : std::size_t{0};
+    return alphabet{std::string_view{traits::alphabet.data(), radix},
+                    &decode_table<T>, bits, traits::padding,
+                    traits::type_case};
+  }
+}
+
+template <std::size_t... I>
+constexpr auto make_alphabets(std::index_sequence<I...> /*indices*/) {
+  constexpr auto values = magic_enum::enum_values<encoding>();
+  return std::array<alphabet, sizeof...(I)>{make_alphabet<values[I]>()...};
+}
+
+constexpr auto alphabets = make_alphabets(
+    std::make_index_sequence<magic_enum::enum_count<encoding>()>{});
+
+const alphabet& alphabet_of(encoding base) {
+  return alphabets.at(magic_enum::enum_index(base).value());
+}
+
+/// Whether two alphabets hold the same characters in the same order, up to
+/// their case
+bool is_same_but_case(const alphabet& lhs, const alphabet& rhs) {
+  return lhs.padding == rhs.padding &&
+         std::ranges::equal(lhs.symbols, rhs.symbols, [](char lch, char rch) {
+           return detail::to_lower(static_cast<unsigned char>(lch)) ==
+                  detail::to_lower(static_cast<unsigned char>(rch));
+         });
+}
+
+/// Input without its trailing padding
+std::string_view payload(std::string_view input, const alphabet& from) {
+  if (from.padding == 0) {
+    return input;
+  }
+  auto last = input.find_last_not_of(from.padding);
+  return input.substr(0, last == std::string_view::npos ? 0 : last + 1);
+}
+
+/// Number of characters which the given number of characters regroup into,
+/// including padding. Bits beyond the last whole byte of the input are
+/// filler and are dropped.
+std::size_t regrouped_size(std::size_t size, const alphabet& from,
+                           const alphabet& to) {
+  auto bits = size * from.bits / byte_bits * byte_bits;
+  auto result = (bits + to.bits - 1) / to.bits;
+  if (to.padding != 0) {
+    auto group = std::lcm(byte_bits, to.bits) / to.bits;
+    result = (result + group - 1) / group * group;
+  }
+  return result;
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunsafe-buffer-usage"
+/// Convert the letters of the input to the given case, leaving everything
+/// else as it is
+void change_case(std::string_view input, std::span<char> output,
+                 encoding_case to) noexcept {
+  if (to != encoding_case::lower && to != encoding_case::upper) {
+    std::ranges::copy(input, output.begin());
+    return;
+  }
+  const auto is_upper = to == encoding_case::upper;
+  auto offset = std::size_t{0};
+#if MULTIBASE_HAVE_SSE2
+  // moving the letters to change onto the bottom of the signed range lets a
+  // single signed compare pick them out
+  constexpr auto letters = 26;
+  const auto first = is_upper ? 'a' : 'A';
+  const auto shift = _mm_set1_epi8(static_cast<char>(0x80 - first));
+  const auto limit = _mm_set1_epi8(static_cast<char>(-0x80 + letters));
+  const auto flip = _mm_set1_epi8('a' - 'A');
+  constexpr auto width = sizeof(__m128i);
+  for (; input.size() - offset >= width; offset += width) {
+    const auto chars = _mm_loadu_si128(
+        static_cast<const __m128i*>(static_cast<const void*>(&input[offset])));
+    const auto is_letter =
+        _mm_cmplt_epi8(_mm_add_epi8(chars, shift), limit);
+    _mm_storeu_si128(static_cast<__m128i*>(static_cast<void*>(&output[offset])),
+                     _mm_xor_si128(chars, _mm_and_si128(is_letter, flip)));
+  }
+#endif
+  for (; offset < input.size(); ++offset) {
+    auto chr = static_cast<unsigned char>(input[offset]);
+    output[offset] = static_cast<char>(is_upper ? detail::to_upper(chr)
+                                                : detail::to_lower(chr));
+  }
+}
+#pragma clang diagnostic pop
+
+/// Regroup the bits of each input character into the characters of another
+/// power of two encoding, accepting the input decoding would
+/// @return number of characters written
+std::size_t regroup(std::string_view input, std::span<char> output,
+                    const alphabet& from, const alphabet& to) {
+  const auto padded_size = input.size();
+  input = payload(input, from);
+  auto size = regrouped_size(input.size(), from, to);
+  if (output.size() < size) {
+    throw std::invalid_argument{fmt::format(
+        "Output of {} characters too small to transcode {} characters",
+        output.size(), input.size())};
+  }
+  auto value_of = [&from](char chr) -> std::uint64_t {
+    const auto val = (*from.values)[static_cast<unsigned char>(chr)];
+    if (val == invalid_value) {
+      throw std::invalid_argument{
+          fmt::format("Invalid input character {}", chr)};
+    }
+    return val;
+  };
+  const auto mask = (std::uint64_t{1} << to.bits) - 1;
+  auto out = output.begin();
+  auto buffer = std::uint64_t{0};
+  auto buffered = std::size_t{0};
+  auto emit = [&]() {
+    while (buffered >= to.bits) {
+      buffered -= to.bits;
+      *out++ = to.symbols[(buffer >> buffered) & mask];
+    }
+  };
+  const auto total_bits = input.size() * from.bits / byte_bits * byte_bits;
+  const auto whole = total_bits / from.bits;
+  for (auto chr : input.substr(0, whole)) {
+    buffer = (buffer << from.bits) | value_of(chr);
+    buffered += from.bits;
+    emit();
+  }
+  // as decoding, a trailing partial group holds at least one byte, no more
+  // characters than it needs, and no bits beyond those of its bytes
+  const auto group = std::lcm(byte_bits, from.bits) / from.bits;
+  const auto remainder = input.size() % group;
+  const auto partial_bytes = remainder * from.bits / byte_bits;
+  if ((partial_bytes * byte_bits + from.bits - 1) / from.bits != remainder) {
+    throw std::invalid_argument{
+        fmt::format("Invalid length of {} characters", input.size())};
+  }
+  if (whole < input.size()) {
+    // only the leading bits of the last character complete the last byte
+    const auto kept = total_bits - whole * from.bits;
+    const auto value = value_of(input[whole]);
+    if ((value & ((std::uint64_t{1} << (from.bits - kept)) - 1)) != 0) {
+      throw std::invalid_argument{fmt::format(
+          "Invalid trailing bits in final character {}", input[whole])};
+    }
+    buffer = (buffer << kept) | (value >> (from.bits - kept));
+    buffered += kept;
+    emit();
+  }
+  if (from.padding != 0) {
+    const auto expected = remainder == 0 ? 0 : group - remainder;
+    if (padded_size - input.size() != expected) {
+      throw std::invalid_argument{
+          fmt::format("Invalid padding of {} characters after {}",
+                      padded_size - input.size(), input.size())};
+    }
+  }
+  if (buffered > 0) {
+    *out++ = to.symbols[(buffer << (to.bits - buffered)) & mask];
+  }
+  std::fill(out, std::next(output.begin(), static_cast<std::ptrdiff_t>(size)),
+            to.padding);
+  return size;
+}
+
+}  // namespace
+
+transcoder::transcoder(encoding from, encoding to)
+    : from_{from},
+      to_{to},
+      method_{method::via_bytes},
+      decoder_{from},
+      encoder_{to} {
+  const auto& source = alphabet_of(from);
+  const auto& target = alphabet_of(to);
+  if (source.bits != 0 && target.bits != 0) {
+    method_ = is_same_but_case(source, target) ? method::change_case
+                                               : method::regroup;
+  }
+}
+
+std::size_t transcoder::transcoded_size(std::string_view input) {
+  switch (method_) {
+    case method::change_case:
+      return input.size();
+    case method::regroup: {
+      const auto& source = alphabet_of(from_);
+      return regrouped_size(payload(input, source).size(), source,
+                            alphabet_of(to_));
+    }
+    case method::via_bytes:
+      break;
+  }
+  return encoder_.encoded_size(decoder_.decoded_size(input));
+}
+
+std::string_view transcoder::transcode(std::string_view input,
+                                       std::span<char> output) {
+  switch (method_) {
+    case method::change_case: {
+      if (output.size() < input.size()) {
+        throw std::invalid_argument{fmt::format(
+            "Output of {} characters too small to transcode {} characters",
+            output.size(), input.size())};
+      }
+      if (auto result = decoder_.validate(input); !result) {
+        throw std::invalid_argument{fmt::format(
+            "Invalid input at offset {}", result.error_offset.value())};
+      }
+      change_case(input, output, alphabet_of(to_).type_case);
+      return {output.data(), input.size()};
+    }
+    case method::regroup:
+      return {output.data(),
+              regroup(input, output, alphabet_of(from_), alphabet_of(to_))};
+    case method::via_bytes:
+      break;
+  }
+  scratch_.resize(decoder_.decoded_size(input));
+  auto bytes = decoder_.decode(input, scratch_);
+  auto size = encoder_.encoded_size(bytes.size());
+  if (output.size() < size) {
+    throw std::invalid_argument{fmt::format(
+        "Output of {} characters too small to transcode {} characters",
+        output.size(), input.size())};
+  }
+  auto space = output.first(size);
+  auto view = encoder_.encode(bytes, space);
+  if (view.data() != space.data()) {
+    std::ranges::copy(view, space.begin());
+  }
+  return {output.data(), view.size()};
+}
+
+std::optional<std::size_t> transcoder::chunk_size() const noexcept {
+  if (method_ != method::via_bytes) {
+    const auto source_bits = alphabet_of(from_).bits;
+    return std::lcm(std::lcm(byte_bits, source_bits), alphabet_of(to_).bits) /
+           source_bits;
+  }
+  if (from_ == encoding::base_none && to_ == encoding::base_none) {
+    return 1;
+  }
+  // one character of base_none is one byte
+  if (from_ == encoding::base_none) {
+    return codec{to_}.decoded_chunk_size();
+  }
+  if (to_ == encoding::base_none) {
+    return codec{from_}.encoded_chunk_size();
+  }
+  return std::nullopt;
+}
+
+std::string transcode(std::string_view input, encoding to, bool multiformat) {
+  if (input.empty()) {
+    throw std::invalid_argument{"Missing multibase prefix"};
+  }
+  return transcode(input.substr(1), decode(input.front()), to, multiformat);
+}
+
+std::string transcode(std::string_view input, encoding from, encoding to,
+                      bool multiformat) {
+  auto converter = transcoder{from, to};
+  const auto offset = multiformat ? std::size_t{1} : std::size_t{0};
+  auto output = std::string(offset + converter.transcoded_size(input), '\0');
+  if (multiformat) {
+    output.front() = encode(to);
+  }
+  auto view = converter.transcode(input, std::span{output}.subspan(offset));
+  output.resize(offset + view.size());
+  return output;
+}
+
+}  // namespace multibase
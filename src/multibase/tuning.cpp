@@ -0,0 +1,431 @@
+// Copyright 2023 Lockblox
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <multibase/tuning.hpp>
+
+#include <algorithm>     // for min, max, clamp, generate, find
+#include <array>         // for array
+#include <atomic>        // for atomic, memory_order_relaxed
+#include <cerrno>        // for errno
+#include <charconv>      // for from_chars
+#include <cstdint>       // for uint8_t
+#include <cstdlib>       // for getenv
+#include <exception>     // for exception
+#include <fstream>       // for ifstream, ofstream
+#include <istream>       // for getline
+#include <limits>        // for numeric_limits
+#include <span>          // for span
+#include <stdexcept>     // for invalid_argument
+#include <string>        // for string
+#include <system_error>  // for system_error, generic_category, errc
+#include <thread>        // for jthread, hardware_concurrency
+#include <utility>       // for pair, exchange
+#include <vector>        // for vector
+
+#include <fmt/core.h>  // for format
+
+#include <multibase/basic_algorithm.hpp>  // for basic_algorithm
+#include <multibase/codec.hpp>            // for codec
+#include <multibase/dispatch.hpp>         // for select_kernel, kernel
+
+namespace multibase {
+
+namespace {
+
+/// Values shared by every thread, each read and written on its own
+class settings {
+ public:
+  explicit settings(const tuning& values) { store(values); }
+
+  [[nodiscard]] tuning load() const noexcept {
+    return {vector_min_size_.load(std::memory_order_relaxed),
+            parallel_min_size_.load(std::memory_order_relaxed),
+            segment_size_.load(std::memory_order_relaxed),
+            threads_.load(std::memory_order_relaxed)};
+  }
+
+  void store(const tuning& values) noexcept {
+    vector_min_size_.store(values.vector_min_size, std::memory_order_relaxed);
+    parallel_min_size_.store(values.parallel_min_size,
+                             std::memory_order_relaxed);
+    segment_size_.store(values.segment_size, std::memory_order_relaxed);
+    threads_.store(values.threads, std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<std::size_t> vector_min_size_;
+  std::atomic<std::size_t> parallel_min_size_;
+  std::atomic<std::size_t> segment_size_;
+  std::atomic<std::size_t> threads_;
+};
+
+/// The defaults, replaced by the profile named by MULTIBASE_TUNING
+tuning initial_tuning() noexcept {
+  // NOLINTNEXTLINE(concurrency-mt-unsafe)
+  if (const auto* path = std::getenv("MULTIBASE_TUNING")) {
+    try {
+      return load_profile(path);
+    } catch (const std::exception&) {  // NOLINT(bugprone-empty-catch)
+      // a profile which cannot be read leaves the defaults
+    }
+  }
+  return {};
+}
+
+settings& current() {
+  static auto result = settings{initial_tuning()};
+  return result;
+}
+
+/// Values which take the place of the shared ones in a thread measuring
+/// candidates, so that other threads keep converting with the active values
+thread_local const tuning* measuring = nullptr;
+
+/// Candidate values seen by active_tuning in this thread while in scope
+class local_tuning {
+ public:
+  explicit local_tuning(const tuning& values) noexcept
+      : previous_{std::exchange(measuring, &values)} {}
+  local_tuning(const local_tuning&) = delete;
+  local_tuning& operator=(const local_tuning&) = delete;
+  ~local_tuning() { measuring = previous_; }
+
+ private:
+  const tuning* previous_;
+};
+
+/// Fields of a profile, in the order they are written
+constexpr auto fields = std::array{
+    std::pair{"vector_min_size", &tuning::vector_min_size},
+    std::pair{"parallel_min_size", &tuning::parallel_min_size},
+    std::pair{"segment_size", &tuning::segment_size},
+    std::pair{"threads", &tuning::threads}};
+
+std::string_view trim(std::string_view text) {
+  constexpr auto space = std::string_view{" \t\r"};
+  const auto first = text.find_first_not_of(space);
+  if (first == std::string_view::npos) {
+    return {};
+  }
+  return text.substr(first, text.find_last_not_of(space) - first + 1);
+}
+
+using clock = std::chrono::steady_clock;
+
+/// Encoding measured, the most widely used of those with vector kernels
+constexpr auto measured_base = encoding::base_64;
+
+/// Input timed to find how much of the sample the budget allows
+constexpr std::size_t probe_size = std::size_t{256} << 10U;
+
+/// Most input of the parallel measurements, enough for several rounds of
+/// the default segment size on a few threads
+constexpr std::size_t max_sample_size = std::size_t{64} << 20U;
+
+/// Throughput within which fewer threads are preferred to more
+constexpr double thread_tolerance = 1.05;
+
+/// Time left for tuning, each measurement taking a fixed share of it
+class budget {
+ public:
+  explicit budget(std::chrono::milliseconds total)
+      : deadline_{clock::now() + total}, slice_{total / slices} {}
+
+  [[nodiscard]] bool exhausted() const { return clock::now() >= deadline_; }
+
+  /// Share of the budget taken by each measurement
+  [[nodiscard]] clock::duration slice() const { return slice_; }
+
+  /// Least time taken by a call of function, calling it once and then, until
+  /// the deadline, at least three times and until its share is spent
+  template <typename Function>
+  [[nodiscard]] double seconds(Function function) const {
+    constexpr auto min_calls = 3;
+    const auto start = clock::now();
+    auto best = std::numeric_limits<double>::max();
+    for (auto calls = 0;
+         calls == 0 || (!exhausted() && (calls < min_calls ||
+                                         clock::now() - start < slice_));
+         ++calls) {
+      const auto call_start = clock::now();
+      function();
+      best = std::min(
+          best,
+          std::chrono::duration<double>(clock::now() - call_start).count());
+    }
+    return best;
+  }
+
+ private:
+  /// Number of measurements the budget is shared between
+  static constexpr auto slices = 64;
+
+  clock::time_point deadline_;
+  clock::duration slice_;
+};
+
+/// Bytes to measure with, whose values do not change the time taken to
+/// encode them and so need not be random
+std::vector<std::byte> sample(std::size_t size) {
+  auto result = std::vector<std::byte>(size);
+  std::generate(result.begin(), result.end(),
+                [value = std::uint8_t{0}]() mutable {
+                  value = static_cast<std::uint8_t>(value * 5U + 1U);
+                  return static_cast<std::byte>(value);
+                });
+  return result;
+}
+
+/// Input of the parallel measurements: what a single thread encodes in a
+/// third of a measurement's share of the budget, from the time taken by a
+/// single call on a probe
+std::size_t measure_sample_size(const budget& timer, codec& encoder) {
+  const auto input = sample(probe_size);
+  auto output = std::string(encoder.encoded_size(probe_size), 0);
+  const auto start = clock::now();
+  encoder.encode(input, output);
+  const auto elapsed = std::chrono::duration<double>(clock::now() - start);
+  const auto share = std::chrono::duration<double>(timer.slice()) / 3;
+  const auto size = static_cast<double>(probe_size) * share.count() /
+                    std::max(elapsed.count(), 1e-9);
+  return static_cast<std::size_t>(std::clamp(
+      size, static_cast<double>(probe_size),
+      static_cast<double>(max_sample_size)));
+}
+
+/// Encode input split between threads in parts of whole chunks, one thread
+/// per part, in rounds of segment bytes per thread
+void encode_parallel(codec& encoder, std::span<const std::byte> input,
+                     std::span<char> output, std::size_t threads,
+                     std::size_t segment) {
+  const auto values = active_tuning();
+  const auto granule = *encoder.decoded_chunk_size();
+  const auto chars = *encoder.encoded_chunk_size();
+  const auto part = std::max(granule, segment / granule * granule);
+  while (!input.empty()) {
+    auto workers = std::vector<std::jthread>{};
+    auto parts = std::size_t{0};
+    for (; parts < threads && !input.empty(); ++parts) {
+      const auto size = std::min(part, input.size());
+      const auto from = input.first(size);
+      const auto to = output.first((size + granule - 1) / granule * chars);
+      input = input.subspan(size);
+      output = output.subspan(to.size());
+      if (parts + 1 == threads || input.empty()) {
+        encoder.encode(from, to);
+      } else {
+        workers.emplace_back([&encoder, &values, from, to] {
+          const auto scope = local_tuning{values};
+          encoder.encode(from, to);
+        });
+      }
+    }
+  }
+}
+
+/// Smallest input for which the vector kernel is no slower than the scalar
+/// one at that size and every larger size measured
+std::size_t measure_vector_min_size(const budget& timer, std::size_t fallback) {
+  const auto* vector = select_kernel(measured_base);
+  if (vector == nullptr || vector->level <= isa::swar) {
+    return fallback;
+  }
+  const auto* scalar = select_kernel(measured_base, isa::swar);
+  decltype(kernel::encode) encode_scalar =
+      &basic_algorithm<measured_base>::encode;
+  if (scalar != nullptr) {
+    encode_scalar = scalar->encode;
+  }
+  constexpr auto sizes =
+      std::array<std::size_t, 8>{16, 32, 64, 128, 256, 512, 1024, 2048};
+  const auto input = sample(sizes.back());
+  auto output = std::string(2 * sizes.back(), 0);
+  // a vector kernel slower at every size measured only takes larger ones
+  auto result = 2 * sizes.back();
+  for (auto size = sizes.rbegin(); size != sizes.rend(); ++size) {
+    if (timer.exhausted()) {
+      return fallback;
+    }
+    const auto chunk = std::span{input}.first(*size);
+    const auto vector_time =
+        timer.seconds([&] { vector->encode(chunk, output); });
+    const auto scalar_time =
+        timer.seconds([&] { encode_scalar(chunk, output); });
+    if (vector_time > scalar_time) {
+      break;
+    }
+    result = *size;
+  }
+  // a vector kernel which is faster at every size measured takes them all
+  return result == sizes.front() ? 0 : result;
+}
+
+}  // namespace
+
+tuning active_tuning() noexcept {
+  return measuring != nullptr ? *measuring : current().load();
+}
+
+void set_tuning(const tuning& values) noexcept { current().store(values); }
+
+tuning tune(std::chrono::milliseconds budget_time) {
+  const auto timer = budget{budget_time};
+  auto result = active_tuning();
+  {
+    // vector kernels take every input while they are measured
+    auto candidate = result;
+    candidate.vector_min_size = 0;
+    const auto scope = local_tuning{candidate};
+    result.vector_min_size =
+        measure_vector_min_size(timer, result.vector_min_size);
+  }
+  // the rest is measured with the values found so far, which become active
+  // once every one has been
+  const auto scope = local_tuning{result};
+
+  const auto hardware =
+      std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+  if (hardware == 1 || timer.exhausted()) {
+    result.threads = hardware == 1 ? 0 : result.threads;
+    set_tuning(result);
+    return result;
+  }
+  auto encoder = codec{measured_base};
+  const auto sample_size = measure_sample_size(timer, encoder);
+  const auto input = sample(sample_size);
+  auto output = std::string(encoder.encoded_size(input.size()), 0);
+  const auto throughput = [&](std::size_t size, std::size_t threads,
+                              std::size_t segment) {
+    const auto sample = std::span{input}.first(size);
+    return static_cast<double>(size) / timer.seconds([&] {
+      encode_parallel(encoder, sample, output, threads, segment);
+    });
+  };
+
+  // threads: powers of two up to every hardware thread, preferring fewer
+  // unless more are clearly faster
+  auto best_threads = std::size_t{1};
+  auto best_rate = throughput(sample_size, 1, result.segment_size);
+  for (auto threads = std::size_t{2}; !timer.exhausted();
+       threads = std::min(threads * 2, hardware)) {
+    const auto rate = throughput(sample_size, threads, result.segment_size);
+    if (rate > best_rate * thread_tolerance) {
+      best_rate = rate;
+      best_threads = threads;
+    }
+    if (threads == hardware) {
+      break;
+    }
+  }
+  result.threads = best_threads == hardware ? 0 : best_threads;
+  if (best_threads == 1) {
+    set_tuning(result);
+    return result;
+  }
+
+  // segment size: a round of each is spread over the threads chosen
+  constexpr auto segments = std::array<std::size_t, 5>{
+      std::size_t{256} << 10U, std::size_t{1} << 20U, std::size_t{4} << 20U,
+      std::size_t{16} << 20U, std::size_t{64} << 20U};
+  auto best_segment_rate = 0.0;
+  for (auto segment : segments) {
+    if (timer.exhausted() || segment * best_threads > sample_size) {
+      break;
+    }
+    const auto rate = throughput(sample_size, best_threads, segment);
+    if (rate > best_segment_rate) {
+      best_segment_rate = rate;
+      result.segment_size = segment;
+    }
+  }
+
+  // parallel threshold: the smallest input which two threads convert faster
+  // than one, each taking half of it
+  for (auto size = std::size_t{16} << 10U; size <= sample_size; size *= 2) {
+    if (timer.exhausted()) {
+      break;
+    }
+    if (throughput(size, 2, size / 2) > throughput(size, 1, size)) {
+      result.parallel_min_size = size / 2;
+      break;
+    }
+  }
+  set_tuning(result);
+  return result;
+}
+
+std::string to_profile(const tuning& values) {
+  auto result = std::string{"# multibase tuning profile\n"};
+  for (const auto& [name, field] : fields) {
+    result += fmt::format("{}={}\n", name, values.*field);
+  }
+  return result;
+}
+
+tuning from_profile(std::string_view profile) {
+  auto result = tuning{};
+  while (!profile.empty()) {
+    const auto end = std::min(profile.find('\n'), profile.size());
+    const auto line = trim(profile.substr(0, end));
+    profile.remove_prefix(std::min(end + 1, profile.size()));
+    if (line.empty() || line.front() == '#') {
+      continue;
+    }
+    const auto equals = line.find('=');
+    const auto name = trim(line.substr(0, equals));
+    const auto field = std::ranges::find(fields, name, [](const auto& entry) {
+      return std::string_view{entry.first};
+    });
+    if (field == fields.end()) {
+      throw std::invalid_argument{
+          fmt::format("Unknown tuning parameter {}", name)};
+    }
+    const auto value = equals == std::string_view::npos
+                           ? std::string_view{}
+                           : trim(line.substr(equals + 1));
+    auto& target = result.*(field->second);
+    const auto* last = value.data() + value.size();
+    if (auto [end_of_value, error] =
+            std::from_chars(value.data(), last, target);
+        value.empty() || error != std::errc{} || end_of_value != last) {
+      throw std::invalid_argument{
+          fmt::format("Invalid value {} of tuning parameter {}", value, name)};
+    }
+  }
+  return result;
+}
+
+void save_profile(const tuning& values, const std::filesystem::path& path) {
+  auto file = std::ofstream{path, std::ios::binary};
+  file << to_profile(values);
+  file.close();
+  if (!file) {
+    throw std::system_error{errno, std::generic_category(), path.string()};
+  }
+}
+
+tuning load_profile(const std::filesystem::path& path) {
+  auto file = std::ifstream{path, std::ios::binary};
+  if (!file) {
+    throw std::system_error{errno, std::generic_category(), path.string()};
+  }
+  auto contents = std::string{};
+  for (auto line = std::string{}; std::getline(file, line);) {
+    contents += line;
+    contents += '\n';
+  }
+  return from_profile(contents);
+}
+
+}  // namespace multibase
@@ -0,0 +1,442 @@
+// Copyright 2023 Lockblox
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <multibase/uring_codec.hpp>
+
+#include <multibase/portability.hpp>  // for MULTIBASE_HAVE_IO_URING
+
+#if MULTIBASE_HAVE_IO_URING
+#include <algorithm>     // for copy, count_if, max, min
+#include <array>         // for array
+#include <cerrno>        // for errno, EINTR
+#include <cstddef>       // for byte, size_t
+#include <cstdint>       // for uint64_t
+#include <span>          // for span
+#include <stdexcept>     // for invalid_argument
+#include <string_view>   // for string_view
+#include <system_error>  // for system_error, generic_category
+#include <utility>       // for pair
+#include <vector>        // for vector
+
+#include <fcntl.h>     // for open, O_RDONLY
+#include <liburing.h>  // for io_uring, io_uring_prep_read_fixed
+#include <sys/stat.h>  // for fstat, S_ISREG
+#include <sys/uio.h>   // for iovec
+#include <unistd.h>    // for pread, pwrite, lseek, close
+
+#include <multibase/aligned_buffer.hpp>  // for aligned_buffer
+#include <multibase/codec.hpp>           // for codec, encode, decode
+#include <multibase/input_source.hpp>    // for input_source
+#endif
+
+namespace multibase {
+
+#if MULTIBASE_HAVE_IO_URING
+namespace {
+
+/// Number of blocks with reads or writes in flight
+constexpr std::size_t depth = 4;
+
+void throw_error(int error, const char* what) {
+  throw std::system_error{error, std::generic_category(), what};
+}
+
+class ring {
+ public:
+  explicit ring(unsigned entries) {
+    if (auto error = ::io_uring_queue_init(entries, &ring_, 0); error < 0) {
+      throw_error(-error, "io_uring_queue_init");
+    }
+  }
+  ring(const ring&) = delete;
+  ring(ring&&) = delete;
+  ring& operator=(const ring&) = delete;
+  ring& operator=(ring&&) = delete;
+  ~ring() { ::io_uring_queue_exit(&ring_); }
+
+  io_uring* get() noexcept { return &ring_; }
+
+  /// Next submission queue entry, tagged with the given user data
+  io_uring_sqe& entry(std::uint64_t data) {
+    auto* result = ::io_uring_get_sqe(&ring_);
+    if (result == nullptr) {
+      throw_error(EBUSY, "io_uring_get_sqe");
+    }
+    ::io_uring_sqe_set_data64(result, data);
+    return *result;
+  }
+
+  /// Wait for the next completion, returning its user data and result
+  std::pair<std::uint64_t, int> wait() {
+    io_uring_cqe* completion = nullptr;
+    if (auto error = ::io_uring_wait_cqe(&ring_, &completion); error < 0) {
+      throw_error(-error, "io_uring_wait_cqe");
+    }
+    if (completion == nullptr) {
+      throw_error(EIO, "io_uring_wait_cqe");
+    }
+    auto result = std::pair{::io_uring_cqe_get_data64(completion),
+                            completion->res};
+    ::io_uring_cqe_seen(&ring_, completion);
+    return result;
+  }
+
+  /// Submit what is queued and wait for count completions, discarding them
+  void discard(std::size_t count) noexcept {
+    ::io_uring_submit(&ring_);
+    while (count > 0) {
+      io_uring_cqe* completion = nullptr;
+      auto error = ::io_uring_wait_cqe(&ring_, &completion);
+      if (error == -EINTR) {
+        continue;
+      }
+      if (error < 0 || completion == nullptr) {
+        return;
+      }
+      ::io_uring_cqe_seen(&ring_, completion);
+      --count;
+    }
+  }
+
+ private:
+  io_uring ring_{};
+};
+
+/// Descriptor of a regular file opened for reading
+class regular_file {
+ public:
+  explicit regular_file(const std::string& filename)
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+      : fd_{::open(filename.c_str(), O_RDONLY | O_CLOEXEC)} {
+    if (fd_ < 0) {
+      throw std::system_error{errno, std::generic_category(), filename};
+    }
+    struct stat info {};
+    if (::fstat(fd_, &info) == 0 && S_ISREG(info.st_mode)) {
+      size_ = static_cast<std::size_t>(info.st_size);
+    }
+  }
+  regular_file(const regular_file&) = delete;
+  regular_file(regular_file&&) = delete;
+  regular_file& operator=(const regular_file&) = delete;
+  regular_file& operator=(regular_file&&) = delete;
+  ~regular_file() { ::close(fd_); }
+
+  [[nodiscard]] int descriptor() const noexcept { return fd_; }
+  /// Size of the file, if it is a regular file
+  [[nodiscard]] std::optional<std::size_t> size() const noexcept {
+    return size_;
+  }
+
+ private:
+  int fd_;
+  std::optional<std::size_t> size_;
+};
+
+bool is_regular(int descriptor) {
+  struct stat info {};
+  return ::fstat(descriptor, &info) == 0 && S_ISREG(info.st_mode);
+}
+
+/// Finish a transfer which the ring left short
+void complete_read(int descriptor, std::span<std::byte> buffer,
+                   std::size_t offset) {
+  while (!buffer.empty()) {
+    auto count = ::pread(descriptor, buffer.data(), buffer.size(),
+                         static_cast<off_t>(offset));
+    if (count <= 0) {
+      if (count < 0 && errno == EINTR) {
+        continue;
+      }
+      throw_error(count < 0 ? errno : EIO, "pread");
+    }
+    buffer = buffer.subspan(static_cast<std::size_t>(count));
+    offset += static_cast<std::size_t>(count);
+  }
+}
+
+void complete_write(int descriptor, std::span<const std::byte> buffer,
+                    std::size_t offset) {
+  while (!buffer.empty()) {
+    auto count = ::pwrite(descriptor, buffer.data(), buffer.size(),
+                          static_cast<off_t>(offset));
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw_error(errno, "pwrite");
+    }
+    buffer = buffer.subspan(static_cast<std::size_t>(count));
+    offset += static_cast<std::size_t>(count);
+  }
+}
+
+/// A read or write of one block
+struct transfer {
+  std::size_t offset{0};
+  std::size_t size{0};
+  bool is_pending{false};
+};
+
+/** Convert size bytes of the input from offset onwards, appending the result
+ to the output at its current position. Reads of the next blocks and writes
+ of the previous ones stay in flight while each block is converted, all
+ through buffers registered with the ring.
+ @param size_of Size of the output of converting a number of input bytes
+ @param convert Convert a block into the given space, returning the number
+ of bytes written
+ @return number of bytes appended to the output */
+template <typename Size, typename Convert>
+std::size_t pipeline(int input, std::size_t offset, std::size_t size,
+                     int output, std::size_t granule, Size size_of,
+                     Convert convert) {
+  const auto block_size =
+      std::max(granule, input_source::block_size / granule * granule);
+  // the buffers outlive the ring, which is left with nothing in flight
+  auto inputs = std::vector<aligned_buffer>{};
+  auto outputs = std::vector<aligned_buffer>{};
+  inputs.reserve(depth);
+  outputs.reserve(depth);
+  auto vectors = std::array<iovec, 2 * depth>{};
+  for (std::size_t slot = 0; slot < depth; ++slot) {
+    inputs.emplace_back(block_size);
+    outputs.emplace_back(size_of(block_size));
+    vectors.at(slot) = {inputs.at(slot).data(), inputs.at(slot).size()};
+    vectors.at(depth + slot) = {outputs.at(slot).data(),
+                                outputs.at(slot).size()};
+  }
+  auto uring = ring{2 * depth};
+  if (auto error = ::io_uring_register_buffers(
+          uring.get(), vectors.data(), static_cast<unsigned>(vectors.size()));
+      error < 0) {
+    throw_error(-error, "io_uring_register_buffers");
+  }
+  auto position = ::lseek(output, 0, SEEK_CUR);
+  if (position < 0) {
+    throw_error(errno, "lseek");
+  }
+  auto output_offset = static_cast<std::size_t>(position);
+
+  auto reads = std::array<transfer, depth>{};
+  auto writes = std::array<transfer, depth>{};
+  // the low bit of the user data tells writes from reads
+  auto tag = [](std::size_t slot, bool is_write) -> std::uint64_t {
+    return (slot << 1U) | (is_write ? 1U : 0U);
+  };
+  auto read = [&](std::size_t index) {
+    const auto slot = index % depth;
+    auto& entry = uring.entry(tag(slot, false));
+    auto& request = reads.at(slot);
+    request = {offset + index * block_size,
+               std::min(block_size, size - index * block_size), true};
+    ::io_uring_prep_read_fixed(&entry, input, inputs.at(slot).data(),
+                               static_cast<unsigned>(request.size),
+                               request.offset, static_cast<int>(slot));
+  };
+  auto reap = [&]() {
+    const auto [data, result] = uring.wait();
+    const auto slot = data >> 1U;
+    const auto is_write = (data & 1U) != 0;
+    auto& request = is_write ? writes.at(slot) : reads.at(slot);
+    request.is_pending = false;
+    if (result < 0) {
+      throw_error(-result, is_write ? "write" : "read");
+    }
+    auto done = static_cast<std::size_t>(result);
+    if (done < request.size) {
+      if (is_write) {
+        complete_write(output, outputs.at(slot).span().first(request.size)
+                                   .subspan(done),
+                       request.offset + done);
+      } else {
+        complete_read(input,
+                      inputs.at(slot).span().first(request.size).subspan(done),
+                      request.offset + done);
+      }
+    }
+  };
+  // wait out every transfer still in flight before an error unwinds the
+  // buffers it uses
+  auto settle = [&]() noexcept {
+    const auto is_pending = [](const transfer& request) {
+      return request.is_pending;
+    };
+    uring.discard(static_cast<std::size_t>(
+        std::ranges::count_if(reads, is_pending) +
+        std::ranges::count_if(writes, is_pending)));
+  };
+
+  const auto blocks = (size + block_size - 1) / block_size;
+  try {
+    for (std::size_t index = 0; index < std::min(depth, blocks); ++index) {
+      read(index);
+    }
+    ::io_uring_submit(uring.get());
+    for (std::size_t index = 0; index < blocks; ++index) {
+      const auto slot = index % depth;
+      while (reads.at(slot).is_pending || writes.at(slot).is_pending) {
+        reap();
+      }
+      auto chunk = inputs.at(slot).span().first(reads.at(slot).size);
+      auto space = outputs.at(slot).span().first(size_of(chunk.size()));
+      auto written = convert(std::span<const std::byte>{chunk}, space);
+      // only padding leaves a block short, and it ends the input
+      if (written < space.size() && index + 1 < blocks) {
+        throw std::invalid_argument{"Padding before the end of the input"};
+      }
+      auto& entry = uring.entry(tag(slot, true));
+      auto& request = writes.at(slot);
+      request = {output_offset, written, true};
+      output_offset += written;
+      ::io_uring_prep_write_fixed(&entry, output, outputs.at(slot).data(),
+                                  static_cast<unsigned>(written),
+                                  request.offset,
+                                  static_cast<int>(depth + slot));
+      // the input buffer is free again for the block depth places ahead
+      if (index + depth < blocks) {
+        read(index + depth);
+      }
+      ::io_uring_submit(uring.get());
+    }
+    for (std::size_t slot = 0; slot < depth; ++slot) {
+      while (writes.at(slot).is_pending) {
+        reap();
+      }
+    }
+  } catch (...) {
+    settle();
+    throw;
+  }
+  if (::lseek(output, static_cast<off_t>(output_offset), SEEK_SET) < 0) {
+    throw_error(errno, "lseek");
+  }
+  return output_offset - static_cast<std::size_t>(position);
+}
+
+std::string_view as_chars(std::span<const std::byte> bytes) {
+  return {static_cast<const char*>(static_cast<const void*>(bytes.data())),
+          bytes.size()};
+}
+
+std::span<char> as_writable_chars(std::span<std::byte> bytes) {
+  return {static_cast<char*>(static_cast<void*>(bytes.data())), bytes.size()};
+}
+
+}  // namespace
+
+bool uring_available() noexcept {
+  static const bool is_available = []() {
+    io_uring probe{};
+    if (::io_uring_queue_init(2, &probe, 0) < 0) {
+      return false;
+    }
+    ::io_uring_queue_exit(&probe);
+    return true;
+  }();
+  return is_available;
+}
+
+bool uring_encode_file(const std::string& filename, output_sink& output,
+                       encoding base, bool multiformat) {
+  auto encoder = codec{base};
+  auto granule = encoder.decoded_chunk_size();
+  if (!uring_available() || base == encoding::base_none || !granule ||
+      output.is_mapped() || output.descriptor() < 0 ||
+      !is_regular(output.descriptor())) {
+    return false;
+  }
+  auto input = regular_file{filename};
+  if (!input.size()) {
+    return false;
+  }
+  if (multiformat) {
+    const auto prefix = encode(base);
+    output.write(std::string_view{&prefix, 1});
+  }
+  output.flush();
+  auto written = pipeline(
+      input.descriptor(), 0, *input.size(), output.descriptor(), *granule,
+      [&encoder](std::size_t size) { return encoder.encoded_size(size); },
+      [&encoder](std::span<const std::byte> chunk, std::span<std::byte> space) {
+        auto chars = as_writable_chars(space);
+        auto view = encoder.encode(chunk, chars);
+        if (view.data() != chars.data()) {
+          std::ranges::copy(view, chars.begin());
+        }
+        return view.size();
+      });
+  output.note_written(written);
+  return true;
+}
+
+bool uring_decode_file(const std::string& filename, output_sink& output,
+                       std::optional<encoding> base) {
+  if (!uring_available() || output.is_mapped() || output.descriptor() < 0 ||
+      !is_regular(output.descriptor())) {
+    return false;
+  }
+  auto input = regular_file{filename};
+  if (!input.size()) {
+    return false;
+  }
+  auto offset = std::size_t{0};
+  if (!base) {
+    auto prefix = std::byte{0};
+    if (*input.size() == 0) {
+      throw std::invalid_argument{"Missing multibase prefix"};
+    }
+    complete_read(input.descriptor(), std::span{&prefix, 1}, 0);
+    base = decode(static_cast<char>(prefix));
+    offset = 1;
+  }
+  auto decoder = codec{*base};
+  auto granule = decoder.encoded_chunk_size();
+  if (*base == encoding::base_none || !granule) {
+    return false;
+  }
+  output.flush();
+  auto written = pipeline(
+      input.descriptor(), offset, *input.size() - offset, output.descriptor(),
+      *granule,
+      [&decoder](std::size_t size) { return decoder.decoded_size(size); },
+      [&decoder](std::span<const std::byte> chunk, std::span<std::byte> space) {
+        auto view = decoder.decode(as_chars(chunk), space);
+        if (view.data() != space.data()) {
+          std::ranges::copy(view, space.begin());
+        }
+        return view.size();
+      });
+  output.note_written(written);
+  return true;
+}
+
+#else
+
+bool uring_available() noexcept { return false; }
+
+bool uring_encode_file(const std::string& /*filename*/,
+                       output_sink& /*output*/, encoding /*base*/,
+                       bool /*multiformat*/) {
+  return false;
+}
+
+bool uring_decode_file(const std::string& /*filename*/,
+                       output_sink& /*output*/,
+                       std::optional<encoding> /*base*/) {
+  return false;
+}
+
+#endif
+
+}  // namespace multibase
@@ -0,0 +1,85 @@
+// Copyright 2023 Lockblox
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <multibase/validation.hpp>
+
+#include <algorithm>  // for any_of
+#include <bit>        // for countr_one
+
+#include <multibase/portability.hpp>  // for MULTIBASE_HAVE_SSE2
+
+#if MULTIBASE_HAVE_SSE2
+#include <emmintrin.h>  // for _mm_cmpeq_epi8, _mm_movemask_epi8
+#endif
+
+namespace multibase {
+
+namespace {
+
+#if MULTIBASE_HAVE_SSE2
+/// Broadcast bounds of a character range
+struct range_vector {
+  __m128i first;
+  __m128i last;
+};
+#endif
+
+bool is_valid(unsigned char chr, const alphabet_ranges& ranges) noexcept {
+  return std::ranges::any_of(ranges.view(), [chr](auto range) {
+    return chr >= range.first && chr <= range.last;
+  });
+}
+
+}  // namespace
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunsafe-buffer-usage"
+std::size_t find_invalid(std::string_view input,
+                         const alphabet_ranges& ranges) noexcept {
+  auto offset = std::size_t{0};
+#if MULTIBASE_HAVE_SSE2
+  // x is in [first, last] iff max(x, first) == x && min(x, last) == x
+  auto bounds = std::array<range_vector, max_char_ranges>{};
+  for (std::size_t i = 0; i < ranges.size; ++i) {
+    bounds.at(i) = {_mm_set1_epi8(static_cast<char>(ranges.ranges.at(i).first)),
+                    _mm_set1_epi8(static_cast<char>(ranges.ranges.at(i).last))};
+  }
+  constexpr auto width = sizeof(__m128i);
+  constexpr auto all_valid = 0xFFFFU;
+  for (; input.size() - offset >= width; offset += width) {
+    const auto chars = _mm_loadu_si128(
+        static_cast<const __m128i*>(static_cast<const void*>(&input[offset])));
+    auto valid = _mm_setzero_si128();
+    for (std::size_t i = 0; i < ranges.size; ++i) {
+      const auto& bound = bounds[i];
+      const auto above = _mm_cmpeq_epi8(_mm_max_epu8(chars, bound.first), chars);
+      const auto below = _mm_cmpeq_epi8(_mm_min_epu8(chars, bound.last), chars);
+      valid = _mm_or_si128(valid, _mm_and_si128(above, below));
+    }
+    const auto mask = static_cast<unsigned>(_mm_movemask_epi8(valid));
+    if (mask != all_valid) {
+      return offset + static_cast<std::size_t>(std::countr_one(mask));
+    }
+  }
+#endif
+  for (; offset < input.size(); ++offset) {
+    if (!is_valid(static_cast<unsigned char>(input[offset]), ranges)) {
+      break;
+    }
+  }
+  return offset;
+}
+#pragma clang diagnostic pop
+
+}  // namespace multibase
@@ -0,0 +1,295 @@
+#!/usr/bin/env python3
+# Copyright 2023 Lockblox
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+"""Run the multibase command line tool on sample inputs and check its output.
+
+The path of the tool is the first argument, and any others are passed on to
+unittest.
+"""
+
+import json
+import os
+import random
+import subprocess
+import sys
+import tempfile
+import unittest
+
+TOOL = ""
+
+
+def sample(size, seed=1):
+    """Bytes of every value, the same for the same size and seed"""
+    return random.Random(seed).randbytes(size)
+
+
+class CommandLine(unittest.TestCase):
+    def setUp(self):
+        self.directory = tempfile.TemporaryDirectory()
+        self.addCleanup(self.directory.cleanup)
+
+    def path(self, name, contents=None):
+        """Path of a file in the test's directory, written when given
+        contents"""
+        result = os.path.join(self.directory.name, name)
+        if contents is not None:
+            with open(result, "wb") as file:
+                file.write(contents)
+        return result
+
+    def read(self, name):
+        with open(self.path(name), "rb") as file:
+            return file.read()
+
+    def run_tool(self, *args, data=b""):
+        """Standard output of the tool, which must succeed"""
+        return self.run_with_errors(*args, data=data)[0]
+
+    def run_with_errors(self, *args, data=b""):
+        """Standard output and standard error of the tool, which must
+        succeed"""
+        result = subprocess.run([TOOL, *args], input=data,
+                                capture_output=True, check=False)
+        self.assertEqual(result.returncode, 0, result.stderr.decode())
+        return result.stdout, result.stderr.decode()
+
+    def test_output_file(self):
+        inputs = [self.path(f"in{size}", sample(size))
+                  for size in (0, 1, 1000, 300000)]
+        for base in ("base_64", "base_32_pad", "base_16", "base_58_btc"):
+            # an encoding which cannot be chunked is quadratic in its input
+            chunkable = base != "base_58_btc"
+            for name in inputs if chunkable else inputs[:3]:
+                with self.subTest(base=base, input=name):
+                    # standard output ends with a newline, a file does not
+                    expected = self.run_tool("-e", base, name)[:-1]
+                    encoded = self.path("encoded")
+                    self.assertEqual(
+                        self.run_tool("-e", base, name, "-o", encoded), b"")
+                    self.assertEqual(self.read("encoded"), expected)
+                    self.run_tool("-d", encoded, "-o", self.path("decoded"))
+                    with open(name, "rb") as file:
+                        self.assertEqual(self.read("decoded"), file.read())
+        # the encodings of several inputs follow one another in the output,
+        # which replaces a longer file
+        encoded = self.path("encoded", b"x" * 1000000)
+        self.run_tool("-e", "base_64", "-m", "false", *inputs, "-o", encoded)
+        expected = b"".join(
+            self.run_tool("-e", "base_64", "-m", "false", name)[:-1]
+            for name in inputs)
+        self.assertEqual(self.read("encoded"), expected)
+        # standard input has no size known in advance
+        data = sample(300000, seed=2)
+        self.run_tool("-e", "base_32", "-o", encoded, data=data)
+        self.run_tool("-d", encoded, "-o", self.path("decoded"))
+        self.assertEqual(self.read("decoded"), data)
+
+    def test_padding_between_blocks(self):
+        # padding which ends the first block of the input, with more after it
+        data = b"M" + b"A" * 1048572 + b"QQ==" + b"QUFB" * 1000
+        name = self.path("padded", data)
+        for args in (["-d"], ["-d", "--threads", "4"],
+                     ["-d", "-o", self.path("decoded")],
+                     ["--to", "base_64", "-o", self.path("transcoded")],
+                     ["--to", "base_16"]):
+            with self.subTest(args=args):
+                result = subprocess.run([TOOL, *args, name],
+                                        capture_output=True, check=False)
+                self.assertNotEqual(result.returncode, 0)
+                self.assertTrue(result.stderr)
+        # an output file is not left holding part of the output
+        self.assertEqual(os.listdir(self.directory.name), ["padded"])
+
+    def test_jobs(self):
+        # sizes which finish out of order when converted concurrently
+        sizes = (2000000, 0, 5, 100000, 1, 700000, 3, 64)
+        inputs = [self.path(f"in{index}", sample(size, seed=index))
+                  for index, size in enumerate(sizes)]
+        for base in ("base_64", "base_32", "base_58_btc"):
+            names = inputs if base != "base_58_btc" else inputs[1:3]
+            with self.subTest(base=base):
+                expected = self.run_tool("-e", base, "-j", "1", *names)
+                for jobs in ("2", "4", "0"):
+                    self.assertEqual(
+                        self.run_tool("-e", base, "-j", jobs, *names),
+                        expected)
+                encoded = []
+                for index, name in enumerate(names):
+                    contents = self.run_tool("-e", base, name)[:-1]
+                    encoded.append(self.path(f"encoded{index}", contents))
+                decoded = self.run_tool("-d", "-j", "3", *encoded)
+                expected = b"".join(self.read(name) for name in names)
+                self.assertEqual(decoded, expected + b"\n")
+
+    def test_threads(self):
+        # several rounds of the default segment size, and a partial one
+        data = sample(9000001)
+        name = self.path("input", data)
+        for base in ("base_64", "base_64_pad", "base_32", "base_16"):
+            with self.subTest(base=base):
+                expected = self.run_tool("-e", base, "--threads", "1", name)
+                for threads in ("2", "3", "8"):
+                    self.assertEqual(
+                        self.run_tool("-e", base, "--threads", threads, name),
+                        expected)
+                    self.assertEqual(
+                        self.run_tool("-e", base, "--threads", threads,
+                                      data=data),
+                        expected)
+                encoded = self.path("encoded", expected[:-1])
+                for threads in ("1", "4"):
+                    self.assertEqual(
+                        self.run_tool("-d", "--threads", threads, encoded),
+                        data + b"\n")
+
+    def test_lines(self):
+        records = [b"hello", b"", b"\x00\xff binary,csv\r",
+                   sample(3000).replace(b"\n", b""), b"x"]
+        bases = ["base_64", "base_32_pad", "base_16", "base_58_btc"]
+        # each record has its own prefix, which changes from one to the next
+        mixed = b"".join(
+            self.run_tool("-e", bases[index % len(bases)], "--lines",
+                          data=record + b"\n")
+            for index, record in enumerate(records))
+        for record, line in zip(records, mixed.split(b"\n")):
+            self.assertEqual(self.run_tool("-d", data=line), record + b"\n")
+        self.assertEqual(self.run_tool("-d", "--lines", data=mixed),
+                         b"".join(record + b"\n" for record in records))
+        self.assertEqual(
+            self.run_tool("--to", "base_16", "--lines", data=mixed),
+            b"".join(self.run_tool("-e", "base_16", data=record)
+                     for record in records))
+        # lines ending in a carriage return decode as the others do
+        crlf = mixed.replace(b"\n", b"\r\n")
+        self.assertEqual(self.run_tool("-d", "--lines", data=crlf),
+                         self.run_tool("-d", "--lines", data=mixed))
+        self.assertEqual(
+            self.run_tool("--to", "base_32", "--lines", data=crlf),
+            self.run_tool("--to", "base_32", "--lines", data=mixed))
+        # a carriage return in a record to encode is part of it
+        text = b"one\r\ntwo\r\n"
+        encoded = self.run_tool("-e", "base_64", "--lines", data=text)
+        self.assertEqual(encoded.count(b"\n"), 2)
+        self.assertEqual(self.run_tool("-d", "--lines", data=encoded), text)
+        # another delimiter, and a last record without one
+        data = b"a,bb,,ccc"
+        encoded = self.run_tool("-e", "base_32", "--delimiter", ",",
+                                data=data)
+        self.assertEqual(encoded.count(b","), 4)
+        self.assertEqual(
+            self.run_tool("-d", "--delimiter", ",", data=encoded),
+            data + b",")
+
+    def test_transcode(self):
+        data = sample(100000)
+        # encodings which cannot be chunked are quadratic in their input
+        quadratic = ("base_58_btc", "base_36")
+        for source in ("base_64", "base_64_pad", "base_32", "base_16",
+                       "base_58_btc"):
+            for target in ("base_32_hex_pad", "base_64_url", "base_16_upper",
+                           "base_36"):
+                with self.subTest(source=source, target=target):
+                    payload = data
+                    if source in quadratic or target in quadratic:
+                        payload = data[:500]
+                    encoded = self.run_tool("-e", source, data=payload)[:-1]
+                    expected = self.run_tool("-e", target, data=payload)
+                    self.assertEqual(
+                        self.run_tool("--to", target, data=encoded), expected)
+                    self.assertEqual(
+                        self.run_tool("--to", target, "--from", source,
+                                      data=encoded[1:]),
+                        expected)
+                    self.assertEqual(
+                        self.run_tool("--to", target, "-m", "false",
+                                      data=encoded),
+                        expected[1:])
+        # a file is transcoded as standard input is
+        name = self.path("input", data)
+        encoded = self.path("encoded",
+                            self.run_tool("-e", "base_64", name)[:-1])
+        self.assertEqual(self.run_tool("--to", "base_32", encoded),
+                         self.run_tool("-e", "base_32", name))
+        for args in (["--from", "base_64"], ["--to", "base_32", "-d"],
+                     ["--to", "base_32", "-e", "base_64"]):
+            result = subprocess.run([TOOL, *args], input=b"mAA",
+                                    capture_output=True, check=False)
+            self.assertNotEqual(result.returncode, 0, args)
+
+    def test_stats(self):
+        sizes = (100000, 0, 3000)
+        inputs = [self.path(f"in{size}", sample(size)) for size in sizes]
+        expected = self.run_tool("-e", "base_64", *inputs)
+        output, errors = self.run_with_errors("-e", "base_64", "--stats",
+                                              *inputs)
+        # statistics never reach the output
+        self.assertEqual(output, expected)
+        lines = errors.splitlines()
+        self.assertEqual(lines[0].split(),
+                         ["bytes", "in", "bytes", "out", "seconds", "MB/s",
+                          "file"])
+        encoded_sizes = [len(self.run_tool("-e", "base_64", name)) - 1
+                         for name in inputs]
+        for line, size, encoded, name in zip(lines[1:], sizes, encoded_sizes,
+                                             inputs):
+            fields = line.split()
+            self.assertEqual(fields[:2], [str(size), str(encoded)])
+            float(fields[2])
+            float(fields[3])
+            self.assertEqual(fields[4], name)
+        total = lines[1 + len(inputs)].split()
+        self.assertEqual(total[:2], [str(sum(sizes)), str(sum(encoded_sizes))])
+        self.assertEqual(total[-1], "total")
+        self.assertRegex(
+            lines[2 + len(inputs)],
+            r"^cpu [0-9.]+ s \(user [0-9.]+ s, system [0-9.]+ s\), "
+            r"kernel \w+, peak RSS [0-9.]+ MiB, \d+ allocations$")
+        self.assertEqual(len(lines), 3 + len(inputs))
+
+        for args in (["-j", "2"], ["--threads", "2"], []):
+            with self.subTest(args=args):
+                output, errors = self.run_with_errors(
+                    "-e", "base_64", "--stats-json", *args, *inputs)
+                self.assertEqual(output, expected)
+                stats = json.loads(errors)
+                self.assertEqual(
+                    sorted(stats),
+                    ["allocations", "bytes_in", "bytes_out", "files",
+                     "kernel", "mb_per_s", "peak_rss_bytes",
+                     "system_seconds", "user_seconds", "wall_seconds"])
+                self.assertEqual(
+                    [(file["name"], file["bytes_in"], file["bytes_out"])
+                     for file in stats["files"]],
+                    list(zip(inputs, sizes, encoded_sizes)))
+                for file in stats["files"]:
+                    self.assertEqual(
+                        sorted(file),
+                        ["bytes_in", "bytes_out", "mb_per_s", "name",
+                         "seconds"])
+                self.assertEqual(stats["bytes_in"], sum(sizes))
+                self.assertEqual(stats["bytes_out"], sum(encoded_sizes))
+                self.assertGreater(stats["allocations"], 0)
+                self.assertGreater(stats["peak_rss_bytes"], 0)
+        # standard input is named -
+        encoded = self.run_tool("-e", "base_64", inputs[0])[:-1]
+        _, errors = self.run_with_errors("-d", "--stats-json", data=encoded)
+        stats = json.loads(errors)
+        self.assertEqual(stats["files"][0]["name"], "-")
+        self.assertEqual(stats["bytes_in"], len(encoded))
+        self.assertEqual(stats["bytes_out"], sizes[0])
+
+
+if __name__ == "__main__":
+    TOOL = sys.argv.pop(1)
+    unittest.main()
@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+# Copyright 2023 Lockblox
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+"""Compare multibase_benchmark JSON output with a stored baseline.
+
+Each benchmark's time is divided by the time of the reference benchmark
+from the same run, BM_Memcpy, so that the baseline carries over between
+machines. A benchmark regresses when its throughput relative to the
+reference falls by more than the tolerance.
+
+Benchmarks run on several threads are left out of that comparison, as the
+threads available differ between machines. Instead the throughput of each on
+N threads is compared with N times its throughput on one, and the scaling
+efficiency must not fall below a minimum.
+"""
+
+import argparse
+import json
+import re
+import sys
+
+REFERENCE = "BM_Memcpy"
+UNITS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+THREADS = re.compile(r"^(?P<name>.*)/threads:(?P<threads>\d+)$")
+
+
+def median_runs(results):
+    """Each benchmark's run, taking the median where it was repeated"""
+    runs = {}
+    medians = set()
+    for run in results["benchmarks"]:
+        name = run["run_name"]
+        if run["run_type"] == "aggregate":
+            if run.get("aggregate_name") != "median":
+                continue
+            medians.add(name)
+        elif name in medians:
+            continue
+        runs[name] = run
+    return runs
+
+
+def relative_times(runs):
+    """Time of each single threaded benchmark as a multiple of the reference
+    time"""
+    times = {name: run["cpu_time"] * UNITS[run["time_unit"]]
+             for name, run in runs.items() if not THREADS.match(name)}
+    if REFERENCE not in times:
+        sys.exit(f"{REFERENCE} is missing from the benchmark results")
+    reference = times.pop(REFERENCE)
+    return {name: time / reference for name, time in times.items()}
+
+
+def check(current, baseline, tolerance):
+    """Print a line per benchmark, returning whether any regressed"""
+    failed = []
+    width = max(map(len, baseline), default=0)
+    print(f"{'benchmark':<{width}}  {'baseline':>10}  {'current':>10}  change")
+    for name, expected in sorted(baseline.items()):
+        if name not in current:
+            print(f"{name:<{width}}  {expected:>10.4g}  {'missing':>10}  FAIL")
+            failed.append(name)
+            continue
+        actual = current[name]
+        # throughput is the inverse of time
+        change = expected / actual - 1
+        verdict = ""
+        if change < -tolerance:
+            verdict = "  REGRESSED"
+            failed.append(name)
+        print(f"{name:<{width}}  {expected:>10.4g}  {actual:>10.4g}  "
+              f"{change:+7.1%}{verdict}")
+    for name in sorted(set(current) - set(baseline)):
+        print(f"{name}: not in baseline")
+    if failed:
+        print(f"\n{len(failed)} of {len(baseline)} benchmarks lost more than "
+              f"{tolerance:.0%} of their throughput relative to {REFERENCE} "
+              f"or are missing:")
+        for name in failed:
+            print(f"  {name}")
+        print("If this is expected, rebuild the baseline with the "
+              "multibase_perf_baseline target.")
+    return bool(failed)
+
+
+def efficiencies(runs):
+    """Throughput of each benchmark on N > 1 threads as a fraction of N times
+    its throughput on one thread"""
+    single = {}
+    multiple = []
+    for name, run in runs.items():
+        match = THREADS.match(name)
+        if not match or "bytes_per_second" not in run:
+            continue
+        threads = int(match["threads"])
+        if threads == 1:
+            single[match["name"]] = run["bytes_per_second"]
+        else:
+            multiple.append((match["name"], threads, run["bytes_per_second"]))
+    return {f"{name}/threads:{threads}":
+            throughput / (threads * single[name])
+            for name, threads, throughput in multiple
+            if single.get(name)}
+
+
+def check_scaling(efficiency, minimum):
+    """Print the scaling efficiency of each threaded benchmark, returning
+    whether any fell below the minimum"""
+    if not efficiency:
+        return False
+    failed = [name for name, value in efficiency.items() if value < minimum]
+    width = max(map(len, efficiency))
+    print(f"\n{'threaded benchmark':<{width}}  efficiency")
+    for name, value in sorted(efficiency.items()):
+        verdict = "  BELOW MINIMUM" if value < minimum else ""
+        print(f"{name:<{width}}  {value:>10.1%}{verdict}")
+    if failed:
+        print(f"\n{len(failed)} threaded benchmarks scale with less than "
+              f"{minimum:.0%} efficiency:")
+        for name in sorted(failed):
+            print(f"  {name}")
+    return bool(failed)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("results", help="multibase_benchmark JSON output")
+    parser.add_argument("baseline", help="baseline JSON file")
+    parser.add_argument("--tolerance", type=float, default=0.25,
+                        help="largest fraction of throughput which may be "
+                        "lost (default 0.25)")
+    parser.add_argument("--min-efficiency", type=float, default=0.75,
+                        help="smallest fraction of linear scaling a threaded "
+                        "benchmark must reach (default 0.75)")
+    parser.add_argument("--update", action="store_true",
+                        help="replace the baseline with the results")
+    args = parser.parse_args()
+
+    with open(args.results, encoding="utf-8") as file:
+        runs = median_runs(json.load(file))
+    current = relative_times(runs)
+    if args.update:
+        with open(args.baseline, "w", encoding="utf-8") as file:
+            json.dump({"reference": REFERENCE,
+                       "benchmarks": {name: float(f"{time:.4g}")
+                                      for name, time in sorted(
+                                          current.items())}},
+                      file, indent=2)
+            file.write("\n")
+        print(f"Wrote {len(current)} benchmarks to {args.baseline}")
+        return 0
+    with open(args.baseline, encoding="utf-8") as file:
+        baseline = json.load(file)["benchmarks"]
+    regressed = check(current, baseline, args.tolerance)
+    unscaled = check_scaling(efficiencies(runs), args.min_efficiency)
+    return 1 if regressed or unscaled else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
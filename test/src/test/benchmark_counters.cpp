@@ -0,0 +1,352 @@
+// Copyright 2023 Lockblox
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma warning(disable : 4068)
+#pragma clang diagnostic ignored "-Wexit-time-destructors"
+#pragma clang diagnostic ignored "-Wglobal-constructors"
+
+#include "benchmark_counters.hpp"
+
+#include <algorithm>  // for max
+#include <array>      // for array
+#include <atomic>     // for atomic, memory_order_relaxed
+#include <chrono>     // for steady_clock, duration_cast, nanoseconds
+#include <cmath>      // for ceil
+#include <cstdlib>    // for malloc, free, aligned_alloc
+#include <new>        // for bad_alloc, align_val_t
+#include <string>     // for string
+#include <utility>    // for pair
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>  // for __rdtsc, _mm_lfence, _mm_clflush
+#elif defined(_M_X64)
+#include <intrin.h>  // for __rdtsc, _mm_lfence, _mm_clflush
+#endif
+
+#if defined(__linux__)
+#include <linux/perf_event.h>  // for perf_event_attr, PERF_TYPE_HARDWARE
+#include <sys/ioctl.h>         // for ioctl
+#include <sys/syscall.h>       // for SYS_perf_event_open
+#include <unistd.h>            // for syscall, read, close
+#endif
+
+namespace {
+
+/// Allocations counted by the threads given a slot, each on its own cache
+/// line so that threads allocating at once do not contend
+struct alignas(64) allocation_slot {
+  std::atomic<std::uint64_t> count{0};
+  std::atomic<std::uint64_t> bytes{0};
+};
+
+/// Threads beyond this many share the slots from the first again
+constexpr std::size_t slot_count = 256;
+
+std::array<allocation_slot, slot_count> allocation_slots{};
+std::atomic<std::size_t> next_slot{0};
+
+/// Slot of the calling thread, claimed on its first allocation. Claiming
+/// allocates nothing, and slots outlive their threads.
+allocation_slot& thread_slot() noexcept {
+  thread_local auto& slot =
+      allocation_slots[next_slot.fetch_add(1, std::memory_order_relaxed) %
+                       slot_count];
+  return slot;
+}
+
+void count(std::size_t size) noexcept {
+  auto& slot = thread_slot();
+  slot.count.fetch_add(1, std::memory_order_relaxed);
+  slot.bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void* allocate(std::size_t size) {
+  count(size);
+  if (auto* ptr = std::malloc(size == 0 ? 1 : size)) {  // NOLINT
+    return ptr;
+  }
+  throw std::bad_alloc{};
+}
+
+#if defined(__linux__)
+void* allocate(std::size_t size, std::align_val_t alignment) {
+  count(size);
+  const auto align = static_cast<std::size_t>(alignment);
+  // aligned_alloc wants a whole number of alignments
+  const auto rounded = (std::max(size, std::size_t{1}) + align - 1) / align *
+                       align;
+  if (auto* ptr = std::aligned_alloc(align, rounded)) {  // NOLINT
+    return ptr;
+  }
+  throw std::bad_alloc{};
+}
+#endif
+
+}  // namespace
+
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }    // NOLINT
+void operator delete[](void* ptr) noexcept { std::free(ptr); }  // NOLINT
+void operator delete(void* ptr, std::size_t /*size*/) noexcept {
+  std::free(ptr);  // NOLINT
+}
+void operator delete[](void* ptr, std::size_t /*size*/) noexcept {
+  std::free(ptr);  // NOLINT
+}
+
+#if defined(__linux__)
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  return allocate(size, alignment);
+}
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+  return allocate(size, alignment);
+}
+void operator delete(void* ptr, std::align_val_t /*alignment*/) noexcept {
+  std::free(ptr);  // NOLINT
+}
+void operator delete[](void* ptr, std::align_val_t /*alignment*/) noexcept {
+  std::free(ptr);  // NOLINT
+}
+void operator delete(void* ptr, std::size_t /*size*/,
+                     std::align_val_t /*alignment*/) noexcept {
+  std::free(ptr);  // NOLINT
+}
+void operator delete[](void* ptr, std::size_t /*size*/,
+                       std::align_val_t /*alignment*/) noexcept {
+  std::free(ptr);  // NOLINT
+}
+#endif
+
+namespace counters {
+
+allocation_totals allocations() noexcept {
+  auto result = allocation_totals{};
+  for (const auto& slot : allocation_slots) {
+    result.count += slot.count.load(std::memory_order_relaxed);
+    result.bytes += slot.bytes.load(std::memory_order_relaxed);
+  }
+  return result;
+}
+
+#if defined(__linux__)
+namespace {
+
+struct event {
+  std::string_view name;
+  std::uint32_t type;
+  std::uint64_t config;
+};
+
+constexpr auto l1d_read_misses =
+    PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8U) |
+    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16U);
+
+constexpr auto events = std::array{
+    event{"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    event{"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    event{"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    event{"l1d_misses", PERF_TYPE_HW_CACHE, l1d_read_misses},
+    event{"llc_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES}};
+
+int open_event(const event& kind, int leader) {
+  auto attr = perf_event_attr{};
+  attr.size = sizeof(attr);
+  attr.type = kind.type;
+  attr.config = kind.config;
+  if (leader < 0) {
+    // members follow the leader, which starts disabled
+    attr.disabled = 1;
+  }
+  // user space only, which an unprivileged process may count
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP;
+  return static_cast<int>(
+      ::syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0));  // NOLINT
+}
+
+}  // namespace
+
+hardware_events::hardware_events() {
+  for (const auto& kind : events) {
+    auto descriptor = open_event(kind, leader_);
+    if (descriptor < 0) {
+      continue;
+    }
+    if (leader_ < 0) {
+      leader_ = descriptor;
+    }
+    names_.push_back(kind.name);
+    descriptors_.push_back(descriptor);
+  }
+}
+
+hardware_events::~hardware_events() {
+  for (auto descriptor : descriptors_) {
+    ::close(descriptor);
+  }
+}
+
+void hardware_events::start() noexcept {
+  if (leader_ >= 0) {
+    ::ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);   // NOLINT
+    ::ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);  // NOLINT
+  }
+}
+
+void hardware_events::stop() noexcept {
+  if (leader_ >= 0) {
+    ::ioctl(leader_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);  // NOLINT
+  }
+}
+
+std::vector<std::pair<std::string_view, std::uint64_t>> hardware_events::read()
+    const {
+  auto result = std::vector<std::pair<std::string_view, std::uint64_t>>{};
+  if (leader_ < 0) {
+    return result;
+  }
+  // the number of events, then the count of each in the order opened
+  auto values = std::vector<std::uint64_t>(1 + names_.size());
+  const auto size = values.size() * sizeof(std::uint64_t);
+  if (::read(leader_, values.data(), size) != static_cast<ssize_t>(size)) {
+    return result;
+  }
+  for (std::size_t i = 0; i < names_.size(); ++i) {
+    result.emplace_back(names_[i], values[1 + i]);
+  }
+  return result;
+}
+#else
+hardware_events::hardware_events() = default;
+hardware_events::~hardware_events() = default;
+void hardware_events::start() noexcept {}
+void hardware_events::stop() noexcept {}
+std::vector<std::pair<std::string_view, std::uint64_t>> hardware_events::read()
+    const {
+  return {};
+}
+#endif
+
+std::uint64_t cycle_clock::now() noexcept {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+  // the fences keep the measured code from being reordered around the read
+  _mm_lfence();
+  const auto ticks = __rdtsc();
+  _mm_lfence();
+  return ticks;
+#elif defined(__aarch64__)
+  std::uint64_t ticks = 0;
+  asm volatile("isb; mrs %0, cntvct_el0" : "=r"(ticks) : : "memory");
+  return ticks;
+#else
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+#endif
+}
+
+double cycle_clock::nanoseconds_per_tick() {
+  static const auto result = [] {
+    using std::chrono::steady_clock;
+    constexpr auto calibration = std::chrono::milliseconds{20};
+    const auto start = steady_clock::now();
+    const auto first = now();
+    while (steady_clock::now() - start < calibration) {
+    }
+    const auto ticks = now() - first;
+    const auto elapsed = std::chrono::duration<double, std::nano>(
+        steady_clock::now() - start);
+    return ticks == 0 ? 1.0 : elapsed.count() / static_cast<double>(ticks);
+  }();
+  return result;
+}
+
+void flush_cache(const void* data, std::size_t size) noexcept {
+  constexpr std::size_t line = 64;
+  const auto* first = static_cast<const char*>(data);
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+  for (std::size_t offset = 0; offset < size; offset += line) {
+    _mm_clflush(first + offset);
+  }
+  _mm_mfence();
+#elif defined(__aarch64__)
+  for (std::size_t offset = 0; offset < size; offset += line) {
+    asm volatile("dc civac, %0" : : "r"(first + offset) : "memory");
+  }
+  asm volatile("dsb ish" : : : "memory");
+#else
+  // without a flush instruction, displace the data by walking a buffer
+  // larger than the last level cache
+  constexpr std::size_t eviction_size = 64 * 1024 * 1024;
+  static auto eviction = std::vector<char>(eviction_size);
+  for (std::size_t offset = 0; offset < eviction.size(); offset += line) {
+    ++eviction[offset];
+  }
+  benchmark::DoNotOptimize(first + size);
+#endif
+}
+
+latency::latency(benchmark::State& state)
+    : state_{state},
+      nanoseconds_per_tick_{cycle_clock::nanoseconds_per_tick()} {
+  ticks_.reserve(static_cast<std::size_t>(state.max_iterations));
+}
+
+void latency::add(std::uint64_t ticks) {
+  const auto nanoseconds = static_cast<double>(ticks) * nanoseconds_per_tick_;
+  state_.SetIterationTime(nanoseconds / 1e9);
+  ticks_.push_back(ticks);
+}
+
+void latency::report() {
+  if (ticks_.empty()) {
+    return;
+  }
+  std::ranges::sort(ticks_);
+  constexpr auto percentiles = std::array{std::pair{"p50", 0.5},
+                                          std::pair{"p90", 0.9},
+                                          std::pair{"p99", 0.99},
+                                          std::pair{"p99.9", 0.999}};
+  for (const auto& [name, fraction] : percentiles) {
+    // nearest rank
+    const auto rank = static_cast<std::size_t>(
+        std::ceil(fraction * static_cast<double>(ticks_.size())));
+    const auto ticks = ticks_[std::max(rank, std::size_t{1}) - 1];
+    state_.counters[name] = static_cast<double>(ticks) * nanoseconds_per_tick_;
+  }
+}
+
+scope::scope(benchmark::State& state)
+    : state_{state}, start_{allocations()} {
+  events_.start();
+}
+
+scope::~scope() {
+  events_.stop();
+  const auto end = allocations();
+  constexpr auto per_iteration = benchmark::Counter::kAvgIterations;
+  state_.counters["allocs"] = benchmark::Counter(
+      static_cast<double>(end.count - start_.count), per_iteration);
+  state_.counters["alloc_bytes"] = benchmark::Counter(
+      static_cast<double>(end.bytes - start_.bytes), per_iteration);
+  for (const auto& [name, value] : events_.read()) {
+    state_.counters[std::string{name}] =
+        benchmark::Counter(static_cast<double>(value), per_iteration);
+  }
+}
+
+}  // namespace counters
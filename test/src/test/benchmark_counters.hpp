@@ -0,0 +1,99 @@
+#ifndef MULTIBASE_BENCHMARK_COUNTERS_HPP
+#define MULTIBASE_BENCHMARK_COUNTERS_HPP
+
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint64_t
+#include <string_view>  // for string_view
+#include <utility>      // for pair
+#include <vector>       // for vector
+
+#include <benchmark/benchmark.h>
+
+namespace counters {
+
+/// Heap allocations made through operator new by the process so far, summed
+/// over the counters each thread keeps
+struct allocation_totals {
+  std::uint64_t count{0};
+  std::uint64_t bytes{0};
+};
+
+allocation_totals allocations() noexcept;
+
+/// Hardware events of the calling thread, counted through perf_event_open.
+/// Events which the kernel or its permissions refuse are left out, so on
+/// other platforms, or with perf_event_paranoid too high, there are none.
+class hardware_events {
+ public:
+  hardware_events();
+  hardware_events(const hardware_events&) = delete;
+  hardware_events(hardware_events&&) = delete;
+  hardware_events& operator=(const hardware_events&) = delete;
+  hardware_events& operator=(hardware_events&&) = delete;
+  ~hardware_events();
+
+  void start() noexcept;
+  void stop() noexcept;
+
+  /// Name and count of each event opened, since the last start
+  [[nodiscard]] std::vector<std::pair<std::string_view, std::uint64_t>> read()
+      const;
+
+ private:
+  int leader_{-1};
+  std::vector<std::string_view> names_;
+  std::vector<int> descriptors_;
+};
+
+/** Measure the timed loop of a benchmark from construction until
+ destruction, reporting allocations, bytes allocated and hardware events per
+ iteration as user counters. Construct it just before the loop so that set
+ up is not counted. */
+class scope {
+ public:
+  explicit scope(benchmark::State& state);
+  scope(const scope&) = delete;
+  scope(scope&&) = delete;
+  scope& operator=(const scope&) = delete;
+  scope& operator=(scope&&) = delete;
+  ~scope();
+
+ private:
+  benchmark::State& state_;
+  allocation_totals start_;
+  hardware_events events_;
+};
+
+/// Time stamps from the processor's cycle counter where it has one which user
+/// space may read, otherwise from steady_clock
+struct cycle_clock {
+  static std::uint64_t now() noexcept;
+
+  /// Length of a tick, measured against steady_clock on first use
+  static double nanoseconds_per_tick();
+};
+
+/// Evict the lines holding data from every level of cache
+void flush_cache(const void* data, std::size_t size) noexcept;
+
+/** Set the manual time of one benchmark iteration from its cycle_clock
+ ticks, and report the p50, p90, p99 and p99.9 latency in nanoseconds of all
+ the iterations as user counters. */
+class latency {
+ public:
+  explicit latency(benchmark::State& state);
+
+  void add(std::uint64_t ticks);
+
+  /// Report the percentiles
+  void report();
+
+ private:
+  benchmark::State& state_;
+  double nanoseconds_per_tick_;
+  std::vector<std::uint64_t> ticks_;
+};
+
+}  // namespace counters
+
+#endif
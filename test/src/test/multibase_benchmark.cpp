@@ -15,24 +15,50 @@
 #pragma warning(disable : 4068)
 #pragma clang diagnostic ignored "-Wexit-time-destructors"
 #pragma clang diagnostic ignored "-Wglobal-constructors"
+// streambuf inlined into istreambuf_iterator trips GCC's null dereference
+// analysis
+#pragma GCC diagnostic ignored "-Wnull-dereference"
 
 #include <benchmark/benchmark.h>
 
-#include <algorithm>   // for fill_n, __copy_fn
-#include <cstdio>      // for snprintf, size_t
-#include <cstring>     // for memcpy
-#include <functional>  // for identity
-#include <iterator>    // for back_insert_iterator
-#include <limits>      // for numeric_limits
+#include <algorithm>    // for fill_n, shuffle, __copy_fn
+#include <array>        // for array
+#include <atomic>       // for atomic, memory_order_acquire
+#include <cstdint>      // for int64_t
+#include <cstdio>       // for snprintf, size_t
+#include <cstring>      // for memcpy
+#include <filesystem>   // for path, temp_directory_path, remove
+#include <fstream>      // for ofstream
+#include <functional>   // for identity
+#include <iterator>     // for back_insert_iterator, istreambuf_iterator
+#include <limits>       // for numeric_limits
+#include <numeric>      // for iota
+#include <optional>     // for nullopt
 #include <random>
+#include <ranges>       // for subrange
 #include <sstream>
-#include <string>  // for string, basic_string
-#include <vector>  // for vector
+#include <stop_token>   // for stop_token
+#include <string>       // for string, basic_string
+#include <string_view>  // for string_view
+#include <thread>       // for thread, jthread, yield
+#include <type_traits>  // for conditional_t
+#include <utility>      // for index_sequence
+#include <vector>       // for vector
 
+#include <magic_enum.hpp>                        // for enum_values
 #include <range/v3/iterator/basic_iterator.hpp>  // for operator!=
 
+#include <multibase/byte_ostream_iterator.hpp>  // for byte_ostream_iterator
 #include <multibase/codec.hpp>
-#include <multibase/encoding.hpp>  // for encoding
+#include <multibase/dispatch.hpp>      // for set_store_mode, store_mode
+#include <multibase/encoding.hpp>      // for encoding
+#include <multibase/input_source.hpp>  // for input_source
+#include <multibase/output_sink.hpp>   // for output_sink
+#include <multibase/stream_codec.hpp>  // for encode_stream
+#include <multibase/transcode.hpp>     // for transcoder
+#include <multibase/uring_codec.hpp>   // for uring_encode_file
+
+#include "benchmark_counters.hpp"  // for scope, latency, cycle_clock
 
 namespace {
 auto constexpr output_size = 2097152;
@@ -41,9 +67,9 @@ std::string get_shuffled_input() {
   constexpr int input_size = 1024 * 1024;
   std::string input(input_size, 0);
   std::minstd_rand simple_rand;  // NOLINT
-  std::ranges::for_each(input, [&simple_rand](char letter) {
-    return letter = static_cast<char>(simple_rand() %
-                                      std::numeric_limits<char>::max());
+  std::ranges::for_each(input, [&simple_rand](char& letter) {
+    letter = static_cast<char>(simple_rand() %
+                               std::numeric_limits<char>::max());
   });
   return input;
 }
@@ -70,10 +96,9 @@ void BM_Multibase_Encode(benchmark::State& state) {  // NOLINT
   static const std::string input = "hello world";
   std::vector<char> output(output_size, 0);
   while (state.KeepRunning()) {
-    auto output_it =
+    auto output_string =
         multibase::encode(input, multibase::encoding::base_16, false);
-    std::string output_string{};
-    std::ranges::copy(output, std::back_inserter(output_string));
+    benchmark::DoNotOptimize(output_string.data());
   }
 }
 
@@ -110,12 +135,595 @@ void BM_Chunk_Encode(benchmark::State& state) {  // NOLINT
     multibase::base_16::encode(input, output);
   }
 }
+
+void BM_Transcode(benchmark::State& state,  // NOLINT
+                  multibase::encoding from, multibase::encoding to) {
+  auto input = get_shuffled_input();
+  auto encoded = multibase::encode(input, from, false);
+  auto converter = multibase::transcoder{from, to};
+  std::vector<char> output(converter.transcoded_size(encoded), 0);
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(converter.transcode(encoded, output));
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(encoded.size()));
+}
+
+/** The matrix below runs every encoding through each entry point at each
+ size. Sizes count unencoded bytes, and so do the bytes processed, so that
+ rates are comparable between encodings and directions. */
+constexpr auto matrix_sizes = std::array<std::int64_t, 6>{
+    16, 34, 1024, 64 * 1024, 1024 * 1024, 16 * 1024 * 1024};
+
+/// Encodings without fixed size chunks take time quadratic in their input,
+/// many seconds per call at 64 KiB, so they stop at this size
+constexpr std::int64_t quadratic_size_limit = 1024;
+
+/// Ways of calling the library
+enum class entry { span, iterator, stream, typed };
+
+template <multibase::encoding T>
+using algorithm_t = std::conditional_t<T == multibase::encoding::base_none,
+                                       multibase::base_none,
+                                       multibase::basic_algorithm<T>>;
+
+std::vector<std::byte> random_bytes(std::int64_t size) {
+  auto result = std::vector<std::byte>(static_cast<std::size_t>(size));
+  std::minstd_rand simple_rand;  // NOLINT
+  std::ranges::generate(result, [&simple_rand]() {
+    return static_cast<std::byte>(simple_rand());
+  });
+  return result;
+}
+
+void set_processed(benchmark::State& state) {
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+  state.SetComplexityN(state.range(0));
+}
+
+/// Report the bytes processed by all threads together, as bytes_per_second,
+/// and by each thread on average
+void set_throughput(benchmark::State& state) {
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+  state.counters["thread_bytes_per_second"] = benchmark::Counter(
+      static_cast<double>(state.iterations() * state.range(0)),
+      benchmark::Counter::kIsRate | benchmark::Counter::kAvgThreads);
+}
+
+template <multibase::encoding T>
+void BM_Matrix_Encode(benchmark::State& state, entry via) {  // NOLINT
+  const auto input = random_bytes(state.range(0));
+  auto encoder = multibase::codec{T};
+  auto output = std::string(encoder.encoded_size(input.size()), 0);
+  const auto chars = std::string{
+      static_cast<const char*>(static_cast<const void*>(input.data())),
+      input.size()};
+  auto measured = counters::scope{state};
+  for (auto _ : state) {
+    switch (via) {
+      case entry::span:
+        benchmark::DoNotOptimize(encoder.encode(input, output));
+        break;
+      case entry::typed:
+        benchmark::DoNotOptimize(algorithm_t<T>::encode(input, output));
+        break;
+      case entry::iterator: {
+        auto encoded = std::string{};
+        multibase::encode(chars, std::back_inserter(encoded), T, false);
+        benchmark::DoNotOptimize(encoded.data());
+        break;
+      }
+      case entry::stream: {
+        auto in = std::istringstream{chars};
+        auto out = std::ostringstream{};
+        multibase::encode(
+            std::ranges::subrange{std::istreambuf_iterator<char>{in},
+                                  std::istreambuf_iterator<char>{}},
+            std::ostreambuf_iterator<char>{out}, T, false);
+        benchmark::DoNotOptimize(out);
+        break;
+      }
+    }
+  }
+  set_processed(state);
+}
+
+template <multibase::encoding T>
+void BM_Matrix_Decode(benchmark::State& state, entry via) {  // NOLINT
+  const auto encoded = multibase::encode(random_bytes(state.range(0)), T,
+                                         false);
+  auto decoder = multibase::codec{T};
+  auto output = std::vector<std::byte>(decoder.decoded_size(encoded));
+  auto measured = counters::scope{state};
+  for (auto _ : state) {
+    switch (via) {
+      case entry::span:
+        benchmark::DoNotOptimize(decoder.decode(encoded, output));
+        break;
+      case entry::typed:
+        benchmark::DoNotOptimize(algorithm_t<T>::decode(encoded, output));
+        break;
+      case entry::iterator: {
+        auto decoded = std::vector<std::byte>{};
+        multibase::decode(encoded, std::back_inserter(decoded), T);
+        benchmark::DoNotOptimize(decoded.data());
+        break;
+      }
+      case entry::stream: {
+        auto in = std::istringstream{encoded};
+        auto out = std::ostringstream{};
+        multibase::decode(
+            std::ranges::subrange{std::istreambuf_iterator<char>{in},
+                                  std::istreambuf_iterator<char>{}},
+            byte_ostream_iterator{out}, T);
+        benchmark::DoNotOptimize(out);
+        break;
+      }
+    }
+  }
+  set_processed(state);
+}
+
+template <multibase::encoding T>
+void BM_Matrix_Validate(benchmark::State& state) {  // NOLINT
+  const auto encoded = multibase::encode(random_bytes(state.range(0)), T);
+  auto measured = counters::scope{state};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(multibase::validate(encoded, T));
+  }
+  set_processed(state);
+}
+
+/// Transcode into base64, which every encoding reaches by regrouping bits,
+/// changing case or through bytes
+template <multibase::encoding T>
+void BM_Matrix_Transcode(benchmark::State& state) {  // NOLINT
+  const auto encoded = multibase::encode(random_bytes(state.range(0)), T,
+                                         false);
+  auto converter = multibase::transcoder{T, multibase::encoding::base_64};
+  auto output = std::string(converter.transcoded_size(encoded), 0);
+  auto measured = counters::scope{state};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(converter.transcode(encoded, output));
+  }
+  set_processed(state);
+}
+
+/// A CIDv1 of raw content addressed by a sha2-256 multihash: the version,
+/// the content type, the hash function, the digest length and the digest
+std::vector<std::byte> cid_bytes() {
+  constexpr auto header = std::array{0x01, 0x55, 0x12, 0x20};
+  auto result = random_bytes(header.size() + 32);
+  std::ranges::transform(header, result.begin(),
+                         [](auto value) { return std::byte(value); });
+  return result;
+}
+
+/// Encode a CID as its text form through the convenience API, which should
+/// allocate no more than the returned string
+void BM_Cid_Encode(benchmark::State& state,  // NOLINT
+                   multibase::encoding base) {
+  const auto cid = cid_bytes();
+  auto measured = counters::scope{state};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(multibase::encode(cid, base));
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(cid.size()));
+}
+
+void BM_Cid_Decode(benchmark::State& state,  // NOLINT
+                   multibase::encoding base) {
+  const auto cid = cid_bytes();
+  const auto text = multibase::encode(cid, base);
+  auto measured = counters::scope{state};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(multibase::decode(text));
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(cid.size()));
+}
+
+constexpr auto latency_sizes = std::array<std::int64_t, 3>{16, 34, 64};
+
+/// Calls timed by each latency benchmark, of which a hundred lie beyond
+/// the 99.9th percentile
+constexpr std::int64_t latency_samples = 100000;
+
+/// Whether each call constructs its codec and allocates its result, as the
+/// convenience API does, or reuses both
+enum class codec_state { cold, warm };
+
+/// Whether the input and output are evicted from cache before each call
+enum class cache_state { hot, flushed };
+
+/// Time each call separately to report its latency percentiles
+void BM_Latency_Encode(benchmark::State& state,  // NOLINT
+                       multibase::encoding base, codec_state codec,
+                       cache_state cache) {
+  const auto input = random_bytes(state.range(0));
+  auto encoder = multibase::codec{base};
+  auto output = std::string(encoder.encoded_size(input.size()), 0);
+  auto timer = counters::latency{state};
+  for (auto _ : state) {
+    if (cache == cache_state::flushed) {
+      counters::flush_cache(input.data(), input.size());
+      counters::flush_cache(output.data(), output.size());
+    }
+    const auto start = counters::cycle_clock::now();
+    if (codec == codec_state::cold) {
+      benchmark::DoNotOptimize(multibase::encode(input, base));
+    } else {
+      benchmark::DoNotOptimize(encoder.encode(input, output));
+    }
+    timer.add(counters::cycle_clock::now() - start);
+  }
+  timer.report();
+  set_processed(state);
+}
+
+void BM_Latency_Decode(benchmark::State& state,  // NOLINT
+                       multibase::encoding base, codec_state codec,
+                       cache_state cache) {
+  const auto encoded = multibase::encode(random_bytes(state.range(0)), base);
+  const auto unprefixed = std::string_view{encoded}.substr(1);
+  auto decoder = multibase::codec{base};
+  auto output = std::vector<std::byte>(decoder.decoded_size(unprefixed));
+  auto timer = counters::latency{state};
+  for (auto _ : state) {
+    if (cache == cache_state::flushed) {
+      counters::flush_cache(encoded.data(), encoded.size());
+      counters::flush_cache(output.data(), output.size());
+    }
+    const auto start = counters::cycle_clock::now();
+    if (codec == codec_state::cold) {
+      benchmark::DoNotOptimize(multibase::decode(encoded));
+    } else {
+      benchmark::DoNotOptimize(decoder.decode(unprefixed, output));
+    }
+    timer.add(counters::cycle_clock::now() - start);
+  }
+  timer.report();
+  set_processed(state);
+}
+
+bool register_latency() {
+  constexpr auto bases = std::array{
+      multibase::encoding::base_16, multibase::encoding::base_32,
+      multibase::encoding::base_58_btc, multibase::encoding::base_64};
+  constexpr auto codecs = std::array{std::pair{codec_state::cold, "cold"},
+                                     std::pair{codec_state::warm, "warm"}};
+  constexpr auto caches =
+      std::array{std::pair{cache_state::hot, "hot"},
+                 std::pair{cache_state::flushed, "flushed"}};
+  for (auto base : bases) {
+    const auto name = std::string{magic_enum::enum_name(base)};
+    for (const auto& [codec, codec_name] : codecs) {
+      for (const auto& [cache, cache_name] : caches) {
+        const auto suffix =
+            name + "/" + codec_name + "/" + cache_name;
+        for (auto* bench :
+             {benchmark::RegisterBenchmark(
+                  ("BM_Latency_Encode/" + suffix).c_str(), BM_Latency_Encode,
+                  base, codec, cache),
+              benchmark::RegisterBenchmark(
+                  ("BM_Latency_Decode/" + suffix).c_str(), BM_Latency_Decode,
+                  base, codec, cache)}) {
+          for (auto size : latency_sizes) {
+            bench->Arg(size);
+          }
+          bench->UseManualTime()->Iterations(latency_samples);
+        }
+      }
+    }
+  }
+  return true;
+}
+
+constexpr auto scaling_sizes = std::array<std::int64_t, 2>{34, 1024};
+
+/// Each thread converts its own input through the convenience API, which
+/// constructs a codec and allocates, so aggregate throughput grows with the
+/// threads unless they contend for something
+void BM_Scaling_Encode(benchmark::State& state,  // NOLINT
+                       multibase::encoding base) {
+  const auto input = random_bytes(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(multibase::encode(input, base));
+  }
+  set_throughput(state);
+}
+
+void BM_Scaling_Decode(benchmark::State& state,  // NOLINT
+                       multibase::encoding base) {
+  const auto encoded = multibase::encode(random_bytes(state.range(0)), base);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(multibase::decode(encoded));
+  }
+  set_throughput(state);
+}
+
+bool register_scaling() {
+  constexpr auto bases = std::array{
+      multibase::encoding::base_16, multibase::encoding::base_32,
+      multibase::encoding::base_58_btc, multibase::encoding::base_64};
+  const auto threads =
+      std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+  for (auto base : bases) {
+    const auto name = std::string{magic_enum::enum_name(base)};
+    for (auto* bench :
+         {benchmark::RegisterBenchmark(("BM_Scaling_Encode/" + name).c_str(),
+                                       BM_Scaling_Encode, base),
+          benchmark::RegisterBenchmark(("BM_Scaling_Decode/" + name).c_str(),
+                                       BM_Scaling_Decode, base)}) {
+      for (auto size : scaling_sizes) {
+        bench->Arg(size);
+      }
+      bench->ThreadRange(1, threads)->UseRealTime();
+    }
+  }
+  return true;
+}
+
+/// Input of the streaming benchmarks, large enough that the output displaces
+/// much of the last level cache when it is written through it
+constexpr std::int64_t streaming_size = std::int64_t{64} << 20;
+
+/** Latency sensitive workload sharing the last level cache, run on a thread
+ of its own alongside each call of a streaming benchmark. It visits the lines
+ of its working set in a random cycle, so that prefetching cannot hide the
+ misses caused by the call evicting them, and between calls it waits with its
+ working set cached. */
+class co_running_workload {
+ public:
+  static constexpr std::size_t size = std::size_t{8} << 20;
+  static constexpr std::size_t line = 64;
+  /// Lines visited between readings of the clock
+  static constexpr std::size_t batch = 256;
+
+  co_running_workload() : lines_(size / line) {
+    auto order = std::vector<std::size_t>(lines_.size());
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    std::shuffle(std::next(order.begin()), order.end(), std::minstd_rand{});
+    for (std::size_t i = 0; i < order.size(); ++i) {
+      lines_[order[i]].next = order[(i + 1) % order.size()];
+    }
+    thread_ = std::jthread{[this](std::stop_token stop) { chase(stop); }};
+  }
+
+  /// Call function while the workload runs
+  template <typename Function>
+  void alongside(Function function) {
+    running_.store(true, std::memory_order_release);
+    function();
+    running_.store(false, std::memory_order_release);
+  }
+
+  /// Stop the workload, and report the mean time it took to visit a line
+  /// during the calls
+  void report(benchmark::State& state) {
+    thread_.request_stop();
+    thread_.join();
+    state.counters["workload_ns_per_line"] =
+        static_cast<double>(ticks_) *
+        counters::cycle_clock::nanoseconds_per_tick() /
+        static_cast<double>(std::max<std::uint64_t>(visits_, 1));
+  }
+
+ private:
+  /// Visit the lines in their cycle while a call runs, counting the batches
+  /// which begin and end within one
+  void chase(const std::stop_token& stop) {
+    auto current = std::size_t{0};
+    // the working set starts out cached, as it would be before a call
+    for (std::size_t i = 0; i < lines_.size(); ++i) {
+      current = lines_[current].next;
+    }
+    while (!stop.stop_requested()) {
+      if (!running_.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+        continue;
+      }
+      const auto start = counters::cycle_clock::now();
+      for (std::size_t i = 0; i < batch; ++i) {
+        current = lines_[current].next;
+      }
+      const auto ticks = counters::cycle_clock::now() - start;
+      if (running_.load(std::memory_order_acquire)) {
+        ticks_ += ticks;
+        visits_ += batch;
+      }
+    }
+    benchmark::DoNotOptimize(current);
+  }
+
+  struct alignas(line) cache_line {
+    std::size_t next{0};
+  };
+
+  std::vector<cache_line> lines_;
+  std::atomic<bool> running_{false};
+  std::uint64_t ticks_{0};
+  std::uint64_t visits_{0};
+  std::jthread thread_;
+};
+
+/// Encode a large input in a store mode, reporting the throughput and the
+/// time taken by a co-running workload to visit each line of its working set
+void BM_Streaming_Encode(benchmark::State& state,  // NOLINT
+                         multibase::encoding base, multibase::store_mode mode) {
+  const auto input = random_bytes(state.range(0));
+  auto encoder = multibase::codec{base};
+  auto output = std::string(encoder.encoded_size(input.size()), 0);
+  auto workload = co_running_workload{};
+  const auto previous = multibase::set_store_mode(mode);
+  for (auto _ : state) {
+    workload.alongside(
+        [&] { benchmark::DoNotOptimize(encoder.encode(input, output)); });
+  }
+  multibase::set_store_mode(previous);
+  workload.report(state);
+  set_processed(state);
+}
+
+void BM_Streaming_Decode(benchmark::State& state,  // NOLINT
+                         multibase::encoding base, multibase::store_mode mode) {
+  const auto encoded =
+      multibase::encode(random_bytes(state.range(0)), base, false);
+  auto decoder = multibase::codec{base};
+  auto output = std::vector<std::byte>(decoder.decoded_size(encoded));
+  auto workload = co_running_workload{};
+  const auto previous = multibase::set_store_mode(mode);
+  for (auto _ : state) {
+    workload.alongside(
+        [&] { benchmark::DoNotOptimize(decoder.decode(encoded, output)); });
+  }
+  multibase::set_store_mode(previous);
+  workload.report(state);
+  set_processed(state);
+}
+
+bool register_streaming() {
+  constexpr auto bases =
+      std::array{multibase::encoding::base_32, multibase::encoding::base_64};
+  constexpr auto modes =
+      std::array{std::pair{multibase::store_mode::cached, "cached"},
+                 std::pair{multibase::store_mode::streaming, "streaming"}};
+  for (auto base : bases) {
+    const auto name = std::string{magic_enum::enum_name(base)};
+    for (const auto& [mode, mode_name] : modes) {
+      const auto suffix = name + "/" + mode_name;
+      benchmark::RegisterBenchmark(("BM_Streaming_Encode/" + suffix).c_str(),
+                                   BM_Streaming_Encode, base, mode)
+          ->Arg(streaming_size);
+      benchmark::RegisterBenchmark(("BM_Streaming_Decode/" + suffix).c_str(),
+                                   BM_Streaming_Decode, base, mode)
+          ->Arg(streaming_size);
+    }
+  }
+  return true;
+}
+
+/// Size of the file each path converts, several of its blocks
+constexpr std::int64_t file_size = std::int64_t{64} << 20U;
+
+/// Ways the command line tool converts one regular file to another
+enum class file_path { mapped, uring };
+
+/// Encode a file to another as the command line tool does, mapping both
+/// into memory by default or with reads and writes through io_uring
+void BM_File_Encode(benchmark::State& state, file_path via) {  // NOLINT
+  if (via == file_path::uring && !multibase::uring_available()) {
+    state.SkipWithError("io_uring is not available");
+    return;
+  }
+  constexpr auto base = multibase::encoding::base_64;
+  const auto directory = std::filesystem::temp_directory_path();
+  const auto input = (directory / "multibase_benchmark.in").string();
+  const auto output = (directory / "multibase_benchmark.out").string();
+  {
+    const auto bytes = random_bytes(state.range(0));
+    auto file = std::ofstream{input, std::ios::binary};
+    file.write(static_cast<const char*>(static_cast<const void*>(bytes.data())),
+               static_cast<std::streamsize>(bytes.size()));
+  }
+  const auto size = 1 + multibase::codec{base}.encoded_size(
+                            static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    if (via == file_path::mapped) {
+      auto source = multibase::input_source{input};
+      auto sink = multibase::output_sink{output, size};
+      multibase::encode_stream(source, sink, base);
+      sink.close();
+    } else {
+      auto sink = multibase::output_sink{output, std::nullopt};
+      if (!multibase::uring_encode_file(input, sink, base)) {
+        state.SkipWithError("io_uring cannot convert the file");
+        break;
+      }
+      sink.close();
+    }
+  }
+  std::filesystem::remove(input);
+  std::filesystem::remove(output);
+  set_processed(state);
+}
+
+benchmark::internal::Benchmark* with_sizes(
+    benchmark::internal::Benchmark* bench, multibase::encoding base) {
+  const auto limit = multibase::codec{base}.decoded_chunk_size()
+                         ? std::numeric_limits<std::int64_t>::max()
+                         : quadratic_size_limit;
+  for (auto size : matrix_sizes) {
+    if (size <= limit) {
+      bench->Arg(size);
+    }
+  }
+  return bench->Complexity();
+}
+
+template <multibase::encoding T>
+void register_matrix() {
+  constexpr auto entries =
+      std::array{std::pair{entry::span, "span"},
+                 std::pair{entry::iterator, "iterator"},
+                 std::pair{entry::stream, "stream"},
+                 std::pair{entry::typed, "typed"}};
+  const auto name = std::string{magic_enum::enum_name(T)};
+  for (const auto& [via, via_name] : entries) {
+    with_sizes(benchmark::RegisterBenchmark(
+                   ("BM_Matrix_Encode/" + name + "/" + via_name).c_str(),
+                   BM_Matrix_Encode<T>, via),
+               T);
+    with_sizes(benchmark::RegisterBenchmark(
+                   ("BM_Matrix_Decode/" + name + "/" + via_name).c_str(),
+                   BM_Matrix_Decode<T>, via),
+               T);
+  }
+  with_sizes(benchmark::RegisterBenchmark(
+                 ("BM_Matrix_Validate/" + name).c_str(), BM_Matrix_Validate<T>),
+             T);
+  with_sizes(
+      benchmark::RegisterBenchmark(("BM_Matrix_Transcode/" + name).c_str(),
+                                   BM_Matrix_Transcode<T>),
+      T);
+}
+
+template <std::size_t... I>
+bool register_matrices(std::index_sequence<I...> /*indices*/) {
+  constexpr auto values = magic_enum::enum_values<multibase::encoding>();
+  (register_matrix<values[I]>(), ...);
+  return true;
+}
+
+[[maybe_unused]] const auto matrix_registered = register_matrices(
+    std::make_index_sequence<magic_enum::enum_count<multibase::encoding>()>{});
+
+[[maybe_unused]] const auto latency_registered = register_latency();
+
+[[maybe_unused]] const auto scaling_registered = register_scaling();
+
+[[maybe_unused]] const auto streaming_registered = register_streaming();
 }  // namespace
 
+BENCHMARK_CAPTURE(BM_Transcode, case, multibase::encoding::base_32_upper,
+                  multibase::encoding::base_32);
+BENCHMARK_CAPTURE(BM_Transcode, regroup, multibase::encoding::base_64,
+                  multibase::encoding::base_32);
 BENCHMARK(BM_Multibase_Encode);
 BENCHMARK(BM_Base_Encode);
 BENCHMARK(BM_C_Encode);
 BENCHMARK(BM_Chunk_Encode);
 BENCHMARK(BM_Memcpy);
+BENCHMARK_CAPTURE(BM_Cid_Encode, base_32, multibase::encoding::base_32);
+BENCHMARK_CAPTURE(BM_Cid_Encode, base_58_btc, multibase::encoding::base_58_btc);
+BENCHMARK_CAPTURE(BM_Cid_Decode, base_32, multibase::encoding::base_32);
+BENCHMARK_CAPTURE(BM_Cid_Decode, base_58_btc, multibase::encoding::base_58_btc);
 BENCHMARK(BM_Stream_Encode);
+BENCHMARK_CAPTURE(BM_File_Encode, mapped, file_path::mapped)
+    ->Arg(file_size)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(BM_File_Encode, io_uring, file_path::uring)
+    ->Arg(file_size)
+    ->UseRealTime();
 BENCHMARK_MAIN();
@@ -20,16 +20,23 @@
 #include <span>  // for span
 
 #include <algorithm>    // for copy, generate, __fo...
+#include <array>        // for array
+#include <atomic>       // for atomic
 #include <cctype>       // for tolower, toupper
+#include <chrono>       // for milliseconds
 #include <cstdlib>      // for rand, size_t
 #include <functional>   // for identity
 #include <iostream>     // for operator<<, ostream
 #include <iterator>     // for back_insert_iterator
 #include <limits>       // for numeric_limits
+#include <numeric>      // for iota
 #include <random>       // for random_device
+#include <ranges>       // for filter, take, sized_range
 #include <stdexcept>    // for invalid_argument
 #include <string>       // for basic_string, string
 #include <string_view>  // for operator<<
+#include <thread>       // for thread
+#include <utility>      // for forward
 #include <vector>       // for allocator, vector
 
 #include "gmock/gmock.h"  // for MakePredicateFormatt...
@@ -40,11 +47,27 @@
 #include <range/v3/iterator/basic_iterator.hpp>  // for operator!=
 #include <range/v3/range_fwd.hpp>                // for cardinality
 
+#include <multibase/basic_algorithm.hpp>    // for basic_algorithm
+#include <multibase/chunks.hpp>             // for encode_chunks
 #include <multibase/codec.hpp>              // for decode, base_64, encode
+#include <multibase/decode_table.hpp>       // for decode_table
+#include <multibase/dispatch.hpp>           // for set_isa, active_kernel
 #include <multibase/encoding.hpp>           // for encoding
 #include <multibase/encoding_case.hpp>      // for encoding_case
 #include <multibase/encoding_metadata.hpp>  // for encoding_metadata
+#include <multibase/instrumentation.hpp>    // for read, snapshot
 #include <multibase/log.hpp>                // for log2
+#include <multibase/ordered_pool.hpp>       // for for_each_ordered
+#include <multibase/portability.hpp>        // for MULTIBASE_HAVE_POSIX_IO
+#include <multibase/server.hpp>             // for serve, operation
+#include <multibase/swar_kernels.hpp>       // for encode, decode
+#include <multibase/transcode.hpp>          // for transcode
+#include <multibase/tuning.hpp>             // for tune, to_profile
+#include <multibase/views.hpp>              // for encode, decode
+
+#if MULTIBASE_HAVE_POSIX_IO
+#include <unistd.h>  // for pipe, read, write, close
+#endif
 
 namespace test {
 
@@ -156,8 +179,11 @@ TEST(Multibase, BlockSize) {  // NOLINT
   EXPECT_THAT(encoded, "ZWxlcGhhbnQ");
 
   auto decoded = std::vector<std::byte>{};
-  multibase::decode("ZWxlcGhhbnQ", std::back_inserter(decoded), base_64);
-  // EXPECT_THAT(decoded, "elephant");
+  // the null terminator of a literal is part of the input, as it is when
+  // encoding, and is not a character of the encoding
+  EXPECT_THROW(
+      multibase::decode("ZWxlcGhhbnQ", std::back_inserter(decoded), base_64),
+      std::invalid_argument);
 
   decoded.clear();
   auto encoded_buffer = std::string{"ZWxlcGhhbnQA"};
@@ -215,12 +241,234 @@ TEST(Multibase, log2) {  // NOLINT
       "bafybeig4swjz7dres3n4qfwziufw2d3skzdsvljv64tugdkayrcwb34yjt",
       "bafybeigi6zad4teafc2krhuhqykbcshe7cfgygve6xhaunkv4wfeuup5i3",
       "bafybeigi6zad4teafc2krhuhqykbcshe7cfgygve6xhaunkv4wfeuup5iy"};
-  std::ranges::for_each(testcases, [](const auto& input) {
-    auto decoded = multibase::decode(std::string{input});
-    EXPECT_FALSE(decoded.empty());
+  // one of each pair sets bits beyond its last byte, which is rejected
+  auto valid = std::size_t{0};
+  std::ranges::for_each(testcases, [&valid](const auto& input) {
+    if (multibase::validate(input)) {
+      ++valid;
+      EXPECT_FALSE(multibase::decode(std::string{input}).empty());
+    } else {
+      EXPECT_THROW(multibase::decode(std::string{input}),
+                   std::invalid_argument);
+    }
+  });
+  EXPECT_THAT(valid, testcases.size() / 2);
+}
+
+TEST(Multibase, DecodeTable) {  // NOLINT
+  using enum multibase::encoding;
+  constexpr auto& base_32_table = multibase::decode_table<base_32>;
+  static_assert(base_32_table['a'] == 0);
+  static_assert(base_32_table['A'] == 0);
+  static_assert(base_32_table['7'] == 31);
+  static_assert(base_32_table['1'] == multibase::invalid_value);
+  constexpr auto& base_64_table = multibase::decode_table<base_64>;
+  static_assert(base_64_table['a'] != base_64_table['A']);
+  static_assert(base_64_table['='] == multibase::invalid_value);
+  static_assert(base_64_table[0xff] == multibase::invalid_value);
+
+  auto high_bit = std::string{"m\xc3\xa9"};
+  EXPECT_THROW(multibase::decode(high_bit), std::invalid_argument);  // NOLINT
+  high_bit = std::string{"f\x80"};
+  EXPECT_THROW(multibase::decode(high_bit), std::invalid_argument);  // NOLINT
+  EXPECT_THAT(multibase::decode(std::string{"F6a6B"}),
+              multibase::decode(std::string{"f6A6b"}));
+}
+
+TEST(Multibase, Validate) {  // NOLINT
+  using enum multibase::encoding;
+  auto result = multibase::validate("MZWxlcGhhbnQ=");
+  EXPECT_TRUE(result);
+  EXPECT_THAT(result.decoded_size, 8);
+  EXPECT_TRUE(multibase::validate("MZWxlcGhhbnQ=", base_64_pad));
+  EXPECT_THAT(multibase::validate("MZWxlcGhhbnQ=", base_64).error_offset, 0);
+  EXPECT_THAT(multibase::validate("mZWxlc!hhbnQ").error_offset, 6);
+  EXPECT_THAT(multibase::validate("MZWxlcGhhbnQ").error_offset, 12);
+  EXPECT_THAT(multibase::validate("MZW=xlcGhhbnQ").error_offset, 3);
+  EXPECT_THAT(multibase::validate("mZWxlcGhhbnQxy").error_offset, 13);
+  EXPECT_THAT(multibase::validate("Bnbswy3dpeB3W64TMMQ").decoded_size, 11);
+  EXPECT_THAT(multibase::validate("f00796573206d616e69202").error_offset, 21);
+  EXPECT_THAT(multibase::validate("z17paNL19xttac0Y").error_offset, 14);
+  EXPECT_FALSE(multibase::validate(""));
+  EXPECT_FALSE(multibase::validate("?abc"));
+
+  std::random_device random;
+  auto random_byte = [&random]() { return static_cast<std::byte>(random()); };
+  std::vector<std::byte> data(static_cast<std::size_t>(
+      random() % std::numeric_limits<unsigned char>::max()));
+  std::generate(begin(data), end(data), random_byte);
+  magic_enum::enum_for_each<multibase::encoding>(
+      [&](multibase::encoding enum_val) {
+        auto encoded = multibase::encode(data, enum_val);
+        auto validated = multibase::validate(encoded, enum_val);
+        EXPECT_TRUE(validated) << magic_enum::enum_name(enum_val);
+        EXPECT_THAT(validated.decoded_size, data.size())
+            << magic_enum::enum_name(enum_val);
+      });
+  // numbers either side of a power of 256, with and without leading zeros
+  for (const auto& bytes :
+       {std::vector<std::byte>(40, std::byte{0xff}),
+        std::vector<std::byte>{std::byte{1}, std::byte{0}, std::byte{0}},
+        std::vector<std::byte>{std::byte{0}, std::byte{0}, std::byte{1}},
+        std::vector<std::byte>{std::byte{0}, std::byte{0xff}}}) {
+    for (auto base : {base_10, base_36, base_58_btc}) {
+      EXPECT_THAT(
+          multibase::validate(multibase::encode(bytes, base)).decoded_size,
+          bytes.size())
+          << magic_enum::enum_name(base) << " " << bytes.size();
+    }
+  }
+}
+
+TEST(Multibase, StrictDecoding) {  // NOLINT
+  using enum multibase::encoding;
+  EXPECT_THROW(multibase::decode(std::string_view{"MZm9v=xyz"}),
+               std::invalid_argument);
+  EXPECT_THROW(multibase::decode(std::string_view{"MZm9vYg="}),
+               std::invalid_argument);
+  EXPECT_THROW(multibase::decode(std::string_view{"MZm9vYh=="}),
+               std::invalid_argument);
+  EXPECT_THROW(multibase::decode(std::string_view{"mZm9vY"}),
+               std::invalid_argument);
+  EXPECT_THAT(multibase::decode(std::string_view{"MZm9vYg=="}).size(), 4);
+  // trailing nulls are invalid input, for decoding as for validation
+  const auto nulls = std::string_view{"mQUFB\0\0\0", 8};
+  EXPECT_THROW(multibase::decode(nulls), std::invalid_argument);
+  EXPECT_FALSE(multibase::validate(nulls));
+  EXPECT_THAT(multibase::decode(nulls.substr(0, 5)).size(), 3);
+
+  // decoding fails exactly when validation does, for every kernel, with
+  // the last character replaced, a stray padding character and truncation
+  auto data = std::vector<std::byte>(100);
+  std::generate(data.begin(), data.end(),
+                [random = std::minstd_rand{}]() mutable {
+                  return static_cast<std::byte>(random());
+                });
+  const auto decodes = [](multibase::codec& decoder, std::string_view input) {
+    auto output = std::vector<std::byte>(decoder.decoded_size(input));
+    try {
+      decoder.decode(input, output);
+      return true;
+    } catch (const std::invalid_argument&) {
+      return false;
+    }
+  };
+  magic_enum::enum_for_each<multibase::encoding>([&](multibase::encoding base) {
+    auto decoder = multibase::codec{base};
+    if (!decoder.decoded_chunk_size() || base == base_none) {
+      return;
+    }
+    for (auto size : {1, 2, 3, 4, 5, 7, 11, 33, 49, 67, 100}) {
+      const auto encoded = multibase::encode(
+          std::span{data}.first(static_cast<std::size_t>(size)), base, false);
+      const auto last = encoded.find_last_not_of('=');
+      auto variants = std::vector<std::string>{encoded.substr(0, last),
+                                               encoded + "=",
+                                               encoded.substr(0, last) + "=" +
+                                                   encoded.substr(last)};
+      for (auto chr = 1; chr < 128; ++chr) {
+        variants.push_back(encoded);
+        variants.back()[last] = static_cast<char>(chr);
+      }
+      for (const auto& variant : variants) {
+        EXPECT_THAT(decodes(decoder, variant),
+                    static_cast<bool>(decoder.validate(variant)))
+            << magic_enum::enum_name(base) << " " << variant;
+      }
+    }
   });
 }
 
+TEST(Multibase, Transcode) {  // NOLINT
+  using enum multibase::encoding;
+  EXPECT_THAT(multibase::transcode("MZWxlcGhhbnQ=", base_16),
+              "f656c657068616e74");
+  EXPECT_THAT(multibase::transcode("f656c657068616e74", base_64_pad),
+              "MZWxlcGhhbnQ=");
+  EXPECT_THAT(multibase::transcode("bmvwgk4dimfxhi", base_32_upper),
+              "BMVWGK4DIMFXHI");
+  EXPECT_THAT(multibase::transcode("BMVWGK4DIMFXHI", base_32_pad),
+              "cmvwgk4dimfxhi===");
+  EXPECT_THAT(multibase::transcode("656C657068616E74", base_16, base_16,
+                                   false),
+              "656c657068616e74");
+  EXPECT_THAT(multibase::transcode("mZWxlcGhhbnQ", base_58_btc),
+              "zHxwBpKd9UKM");
+  EXPECT_THROW(multibase::transcode("mZWx!cGhhbnQ", base_16),  // NOLINT
+               std::invalid_argument);
+  EXPECT_THROW(multibase::transcode("bmvwgk4d!mfxhi", base_32_upper),  // NOLINT
+               std::invalid_argument);
+  // regrouping bits accepts what decoding does, and nothing more
+  for (const auto* invalid : {"MZm9vYg=", "MZm9v=Yg==", "MZm9vYh==",
+                              "mZm9vY", "mZm9vYh", "bmzxw6y", "cmzxw6yq===="}) {
+    EXPECT_THROW(multibase::decode(std::string_view{invalid}),  // NOLINT
+                 std::invalid_argument)
+        << invalid;
+    EXPECT_THROW(multibase::transcode(invalid, base_16),  // NOLINT
+                 std::invalid_argument)
+        << invalid;
+  }
+  EXPECT_THAT(multibase::transcode("cmzxw6yq=", base_64),
+              multibase::encode(multibase::decode(std::string{"cmzxw6yq="}),
+                                base_64));
+
+  std::random_device random;
+  auto random_byte = [&random]() { return static_cast<std::byte>(random()); };
+  std::vector<std::byte> data(static_cast<std::size_t>(
+      random() % std::numeric_limits<unsigned char>::max()));
+  std::generate(begin(data), end(data), random_byte);
+  magic_enum::enum_for_each<multibase::encoding>([&](multibase::encoding from) {
+    auto encoded = multibase::encode(data, from);
+    magic_enum::enum_for_each<multibase::encoding>(
+        [&](multibase::encoding to) {
+          EXPECT_THAT(multibase::transcode(encoded, to),
+                      multibase::encode(data, to))
+              << magic_enum::enum_name(from) << " to "
+              << magic_enum::enum_name(to);
+        });
+  });
+}
+
+TEST(Multibase, OrderedPool) {  // NOLINT
+  constexpr auto count = std::size_t{100};
+  std::vector<std::size_t> expected(count);
+  std::iota(begin(expected), end(expected), 0);
+  std::vector<std::size_t> consumed;
+  multibase::for_each_ordered(
+      count, 4, 3, [](std::size_t index) { return index; },
+      [&consumed](std::size_t index) { consumed.push_back(index); });
+  EXPECT_THAT(consumed, expected);
+
+  consumed.clear();
+  auto produce = [](std::size_t index) {
+    if (index == 10) {
+      throw std::invalid_argument{"failed"};
+    }
+    return index;
+  };
+  EXPECT_THROW(  // NOLINT
+      multibase::for_each_ordered(
+          count, 4, 3, produce,
+          [&consumed](std::size_t index) { consumed.push_back(index); }),
+      std::invalid_argument);
+  EXPECT_THAT(consumed.size(), 10);
+}
+
+TEST(Multibase, IteratorRoundTrip) {  // NOLINT
+  using std::string_literals::operator""s;
+  auto data = "\0\0yes mani !\xff"s;
+  magic_enum::enum_for_each<multibase::encoding>(
+      [&](multibase::encoding enum_val) {
+        auto encoded = std::string{};
+        multibase::encode(data, std::back_inserter(encoded), enum_val);
+        EXPECT_THAT(encoded, multibase::encode(data, enum_val));
+        auto decoded = std::vector<std::byte>{};
+        multibase::decode(encoded, std::back_inserter(decoded));
+        EXPECT_THAT(decoded, ::testing::ElementsAreArray(
+                                 std::as_bytes(std::span{data})));
+      });
+}
+
 TEST(Multibase, RandomData) {  // NOLINT
   std::random_device random;
   auto random_byte = [&random]() { return static_cast<std::byte>(random()); };
@@ -235,6 +483,567 @@ TEST(Multibase, RandomData) {  // NOLINT
       });
 }
 
+template <typename function>
+std::string error_message(function&& call) {
+  try {
+    std::forward<function>(call)();
+  } catch (const std::invalid_argument& error) {
+    return error.what();
+  }
+  return {};
+}
+
+/// SWAR kernel of T gives the same results and errors as the portable one
+template <multibase::encoding T>
+void expect_swar_matches() {
+  using portable = multibase::basic_algorithm<T>;
+  auto data = std::vector<std::byte>(40);
+  std::generate(data.begin(), data.end(), [i = 0U]() mutable {
+    return static_cast<std::byte>(i++ * 97 + 13);
+  });
+  for (std::size_t size = 0; size <= data.size(); ++size) {
+    const auto input = std::span<const std::byte>{data}.first(size);
+    auto buffer = std::string(portable::encoded_size(size), 0);
+    const auto encoded = std::string{portable::encode(input, buffer)};
+    auto output = std::string(buffer.size(), 0);
+    EXPECT_THAT(multibase::swar::encode<T>(input, output), encoded);
+    auto decoded = std::vector<std::byte>(portable::decoded_size(encoded));
+    EXPECT_THAT(multibase::swar::decode<T>(encoded, decoded),
+                ::testing::ElementsAreArray(input));
+    if (size > 0) {
+      auto short_output = std::string(encoded.size() - 1, 0);
+      EXPECT_THAT(error_message([&] {
+                    multibase::swar::encode<T>(input, short_output);
+                  }),
+                  error_message([&] {
+                    portable::encode(input, short_output);
+                  }));
+      auto short_decoded = std::vector<std::byte>(size - 1);
+      EXPECT_THAT(error_message([&] {
+                    multibase::swar::decode<T>(encoded, short_decoded);
+                  }),
+                  error_message([&] {
+                    portable::decode(encoded, short_decoded);
+                  }));
+    }
+    for (std::size_t i = 0; i < encoded.size(); ++i) {
+      auto invalid = encoded;
+      invalid[i] = '*';
+      EXPECT_THAT(
+          error_message([&] { multibase::swar::decode<T>(invalid, decoded); }),
+          error_message([&] { portable::decode(invalid, decoded); }));
+    }
+  }
+}
+
+template <multibase::encoding... bases>
+void expect_swar_kernels_match() {
+  (expect_swar_matches<bases>(), ...);
+}
+
+TEST(Multibase, SwarKernels) {  // NOLINT
+  using enum multibase::encoding;
+  expect_swar_kernels_match<base_16, base_16_upper, base_32, base_32_upper,
+                            base_32_pad, base_32_pad_upper, base_32_hex,
+                            base_32_hex_upper, base_32_hex_pad,
+                            base_32_hex_pad_upper, base_32_z, base_64,
+                            base_64_pad, base_64_url, base_64_url_pad>();
+}
+
+TEST(Multibase, KernelDispatch) {  // NOLINT
+  // several blocks of every vector kernel, and a partial one
+  auto data = std::string(300, 0);
+  std::iota(std::next(data.begin(), 2), data.end(), '\x80');
+  const auto expected = [&] {
+    multibase::set_isa(multibase::isa::scalar);
+    auto result = std::vector<std::string>{};
+    magic_enum::enum_for_each<multibase::encoding>(
+        [&](multibase::encoding enum_val) {
+          EXPECT_THAT(multibase::active_kernel(enum_val), "scalar");
+          result.push_back(multibase::encode(data, enum_val));
+        });
+    return result;
+  }();
+  // every level the processor supports gives the same results
+  for (auto level : magic_enum::enum_values<multibase::isa>()) {
+    if (level > multibase::detected_isa()) {
+      break;
+    }
+    EXPECT_THAT(multibase::set_isa(level), level);
+    auto encoded = expected.begin();
+    magic_enum::enum_for_each<multibase::encoding>(
+        [&](multibase::encoding enum_val) {
+          EXPECT_THAT(multibase::encode(data, enum_val), *encoded++)
+              << multibase::active_kernel(enum_val);
+          EXPECT_THAT(multibase::decode(multibase::encode(data, enum_val)),
+                      ::testing::ElementsAreArray(
+                          std::as_bytes(std::span{data})));
+          if (enum_val != multibase::encoding::base_none) {
+            auto invalid = multibase::encode(data, enum_val);
+            invalid[invalid.size() / 2] = '*';
+            EXPECT_THROW(multibase::decode(invalid),  // NOLINT
+                         std::invalid_argument);
+          }
+        });
+  }
+  EXPECT_THAT(multibase::set_isa(multibase::isa::avx512),
+              multibase::detected_isa());
+}
+
+/// Output of a conversion into a buffer of size elements, followed by the
+/// whole buffer, or the message of the error it threw
+template <typename element, typename function>
+std::string outcome(std::size_t size, function&& convert) {
+  auto buffer = std::vector<element>(size, element{'#'});
+  auto result = std::string{};
+  const auto append = [&result](auto values) {
+    for (auto value : std::as_bytes(std::span{values})) {
+      result += std::to_integer<char>(value);
+    }
+  };
+  try {
+    append(std::forward<function>(convert)(std::span{buffer}));
+  } catch (const std::invalid_argument& error) {
+    return error.what();
+  }
+  result += " in ";
+  append(buffer);
+  return result;
+}
+
+/// Kernels of level convert input as the portable codec of base does, and
+/// throw the same errors, into outputs of every size about the one needed
+void expect_kernel_matches(multibase::encoding base, multibase::isa level,
+                           std::span<const std::byte> input,
+                           std::minstd_rand& random) {
+  multibase::set_isa(multibase::isa::scalar);
+  auto portable = multibase::codec{base};
+  multibase::set_isa(level);
+  auto kernel = multibase::codec{base};
+  const auto encode = [&input](multibase::codec& encoder) {
+    return [&encoder, &input](std::span<char> output) {
+      return encoder.encode(input, output);
+    };
+  };
+  const auto size = portable.encoded_size(input.size());
+  for (auto slack = std::size_t{0}; slack <= 4; ++slack) {
+    if (size + slack < 2) {
+      continue;
+    }
+    EXPECT_THAT(outcome<char>(size + slack - 2, encode(kernel)),
+                outcome<char>(size + slack - 2, encode(portable)))
+        << magic_enum::enum_name(base) << " of " << input.size() << " bytes";
+  }
+
+  auto encoded = std::string(size, 0);
+  encoded = portable.encode(input, encoded);
+  const auto at_random = [&](std::string text, char replacement) {
+    if (!text.empty()) {
+      text[random() % text.size()] = replacement;
+    }
+    return text;
+  };
+  const auto fold = [](std::string text, auto to_case) {
+    std::ranges::transform(text, text.begin(), [&](char chr) {
+      return static_cast<char>(to_case(static_cast<unsigned char>(chr)));
+    });
+    return text;
+  };
+  const auto inputs = std::array{
+      encoded,
+      at_random(encoded, '*'),
+      at_random(encoded, static_cast<char>(0x80U | random())),
+      at_random(encoded, '='),
+      at_random(encoded, '\0'),
+      encoded + '=',
+      encoded.substr(0, encoded.size() - std::min<std::size_t>(1, size)),
+      fold(encoded, [](int chr) { return std::toupper(chr); }),
+      fold(encoded, [](int chr) { return std::tolower(chr); })};
+  for (const auto& chars : inputs) {
+    const auto decode = [&chars](multibase::codec& decoder) {
+      return [&decoder, &chars](std::span<std::byte> output) {
+        return decoder.decode(chars, output);
+      };
+    };
+    const auto needed = portable.decoded_size(chars);
+    for (auto slack = std::size_t{0}; slack <= 3; ++slack) {
+      if (needed + slack < 2) {
+        continue;
+      }
+      EXPECT_THAT(outcome<std::byte>(needed + slack - 2, decode(kernel)),
+                  outcome<std::byte>(needed + slack - 2, decode(portable)))
+          << magic_enum::enum_name(base) << " decoding " << chars;
+    }
+  }
+}
+
+TEST(Multibase, KernelsMatchPortable) {  // NOLINT
+  using multibase::store_mode;
+  auto random = std::minstd_rand{};
+  auto data = std::vector<std::byte>(700);
+  std::generate(data.begin(), data.end(), [&random] {
+    return static_cast<std::byte>(random());
+  });
+  for (auto level : magic_enum::enum_values<multibase::isa>()) {
+    if (level > multibase::detected_isa()) {
+      break;
+    }
+    magic_enum::enum_for_each<multibase::encoding>(
+        [&](multibase::encoding base) {
+          // each kernel once, at the level which introduces it
+          const auto* kernel = multibase::select_kernel(base, level);
+          if (kernel == nullptr || kernel->level != level) {
+            return;
+          }
+          for (auto mode : {store_mode::cached, store_mode::streaming}) {
+            multibase::set_store_mode(mode);
+            for (auto size = std::size_t{0}; size <= data.size();
+                 size += size < 200 ? 1 : 37) {
+              expect_kernel_matches(base, level,
+                                    std::span{data}.first(size), random);
+            }
+          }
+        });
+  }
+  multibase::set_store_mode(store_mode::automatic);
+  multibase::set_isa(multibase::isa::avx512);
+}
+
+TEST(Multibase, StreamingStores) {  // NOLINT
+  using enum multibase::encoding;
+  // several rounds of staging, written to an output off a cache line
+  auto data = std::string(20000, 0);
+  std::iota(data.begin(), data.end(), '\x01');
+  EXPECT_THAT(multibase::set_store_mode(multibase::store_mode::cached),
+              multibase::store_mode::automatic);
+  const auto threshold = multibase::streaming_threshold();
+  EXPECT_FALSE(multibase::streams(threshold));
+  for (auto mode : {multibase::store_mode::streaming,
+                    multibase::store_mode::automatic}) {
+    multibase::set_store_mode(multibase::store_mode::cached);
+    const auto expected = std::vector{multibase::encode(data, base_64),
+                                      multibase::encode(data, base_32_pad)};
+    multibase::set_streaming_threshold(0);
+    EXPECT_THAT(multibase::set_store_mode(mode),
+                multibase::store_mode::cached);
+    EXPECT_TRUE(multibase::streams(1));
+    for (const auto& encoded : expected) {
+      EXPECT_THAT(multibase::encode(data, multibase::decode(encoded[0])),
+                  encoded);
+      EXPECT_THAT(multibase::decode(encoded),
+                  ::testing::ElementsAreArray(
+                      std::as_bytes(std::span{data})));
+    }
+  }
+  multibase::set_streaming_threshold(threshold);
+  EXPECT_FALSE(multibase::streams(threshold - 1));
+  EXPECT_TRUE(multibase::streams(threshold));
+  multibase::set_store_mode(multibase::store_mode::automatic);
+}
+
+TEST(Multibase, Tuning) {  // NOLINT
+  using enum multibase::encoding;
+  const auto previous = multibase::active_tuning();
+  const auto values = multibase::tuning{1, 2, 3, 4};
+  EXPECT_THAT(multibase::from_profile(multibase::to_profile(values)), values);
+  EXPECT_THAT(multibase::from_profile("\n# comment\n threads = 4 \r\n"),
+              (multibase::tuning{.threads = 4}));
+  EXPECT_THROW(multibase::from_profile("block=1"), std::invalid_argument);
+  EXPECT_THROW(multibase::from_profile("threads=-1"), std::invalid_argument);
+  EXPECT_THROW(multibase::from_profile("threads=4k"), std::invalid_argument);
+  EXPECT_THROW(multibase::from_profile("threads"), std::invalid_argument);
+
+  auto data = std::string(5000, 0);
+  std::iota(data.begin(), data.end(), '\x01');
+  const auto expected = std::vector{multibase::encode(data, base_64),
+                                    multibase::encode(data, base_32)};
+  // other threads keep the active values while the candidates are measured
+  const auto before = multibase::tuning{.vector_min_size = 12345};
+  multibase::set_tuning(before);
+  auto tuning_done = std::atomic<bool>{false};
+  auto background = multibase::tuning{};
+  auto tuner = std::jthread{[&] {
+    background = multibase::tune(std::chrono::milliseconds{100});
+    tuning_done = true;
+  }};
+  auto seen = std::vector<multibase::tuning>{};
+  while (!tuning_done) {
+    seen.push_back(multibase::active_tuning());
+    std::this_thread::yield();
+  }
+  tuner.join();
+  EXPECT_THAT(seen, ::testing::Each(::testing::AnyOf(before, background)));
+  const auto tuned = multibase::tune(std::chrono::milliseconds{100});
+  EXPECT_THAT(multibase::active_tuning(), tuned);
+  EXPECT_THAT(tuned.threads,
+              ::testing::Le(std::thread::hardware_concurrency()));
+  EXPECT_THAT(tuned.segment_size, ::testing::Gt(0));
+  // every input taken by the scalar kernel, then by the vector kernel
+  for (auto min_size : {std::numeric_limits<std::size_t>::max(),
+                        std::size_t{0}}) {
+    multibase::set_tuning({.vector_min_size = min_size});
+    for (const auto& encoded : expected) {
+      EXPECT_THAT(multibase::encode(data, multibase::decode(encoded[0])),
+                  encoded);
+      EXPECT_THAT(multibase::decode(encoded),
+                  ::testing::ElementsAreArray(
+                      std::as_bytes(std::span{data})));
+    }
+  }
+  multibase::set_tuning(previous);
+}
+
+/// Elements of a single pass range
+template <std::ranges::input_range range>
+auto collect(range&& input) {
+  auto result = std::vector<std::ranges::range_value_t<range>>{};
+  for (auto value : input) {
+    result.push_back(value);
+  }
+  return result;
+}
+
+TEST(Multibase, Views) {  // NOLINT
+  namespace views = multibase::views;
+  // several blocks of every encoding, and not a whole number of chunks
+  auto data = std::string(5001, 0);
+  std::iota(data.begin(), data.end(), '\x01');
+  const auto bytes = std::as_bytes(std::span{data});
+  const auto odd = [](char chr) { return (chr & 1) != 0; };
+  auto odd_data = std::string{};
+  std::ranges::copy_if(data, std::back_inserter(odd_data), odd);
+  magic_enum::enum_for_each<multibase::encoding>([&](multibase::encoding base) {
+    const auto expected = multibase::encode(data, base);
+    auto encoded = data | views::encode(base);
+    static_assert(std::ranges::sized_range<decltype(encoded)>);
+    EXPECT_THAT(encoded.size(), expected.size()) << magic_enum::enum_name(base);
+    EXPECT_THAT(collect(encoded), ::testing::ElementsAreArray(expected));
+    auto unsized = data | std::views::filter(odd) | views::encode(base);
+    static_assert(!std::ranges::sized_range<decltype(unsized)>);
+    EXPECT_THAT(collect(unsized),
+                ::testing::ElementsAreArray(multibase::encode(odd_data, base)));
+
+    auto decoded = expected | views::decode();
+    EXPECT_THAT(decoded.size(), data.size()) << magic_enum::enum_name(base);
+    EXPECT_THAT(collect(decoded), ::testing::ElementsAreArray(bytes));
+    const auto unprefixed = std::string_view{expected}.substr(1);
+    EXPECT_THAT(collect(views::decode(unprefixed, base)),
+                ::testing::ElementsAreArray(bytes));
+    // neither end of the chain is held whole
+    auto chain = data | std::views::filter(odd) | views::encode(base, false) |
+                 views::decode(base) | std::views::take(100);
+    EXPECT_THAT(collect(chain), ::testing::ElementsAreArray(
+                                    std::as_bytes(std::span{odd_data})
+                                        .first(100)));
+  });
+  EXPECT_THROW(collect(std::string_view{} | views::decode()),
+               std::invalid_argument);
+  auto invalid = multibase::encode(data, multibase::encoding::base_64);
+  invalid.back() = '!';
+  auto decoded = std::vector<std::byte>{};
+  EXPECT_THROW(
+      std::ranges::copy(invalid | views::decode(), std::back_inserter(decoded)),
+      std::invalid_argument);
+  // blocks before the invalid one have been passed on
+  EXPECT_THAT(decoded.size(), ::testing::Gt(0));
+}
+
+/// Pieces of input of a few sizes in turn, as reads might return them
+std::vector<std::string_view> split(std::string_view input) {
+  constexpr auto sizes = std::array<std::size_t, 6>{1, 0, 2, 7, 100, 1500};
+  auto result = std::vector<std::string_view>{};
+  for (auto i = std::size_t{0}; !input.empty(); ++i) {
+    const auto size = std::min(sizes.at(i % sizes.size()), input.size());
+    result.push_back(input.substr(0, size));
+    input.remove_prefix(size);
+  }
+  return result;
+}
+
+TEST(Multibase, Chunks) {  // NOLINT
+  auto data = std::string(5001, 0);
+  std::iota(data.begin(), data.end(), '\x01');
+  const auto bytes = std::as_bytes(std::span{data});
+  const auto pieces = split(data);
+  magic_enum::enum_for_each<multibase::encoding>([&](multibase::encoding base) {
+    const auto expected = multibase::encode(data, base);
+    auto encoded = std::string{};
+    auto yields = std::size_t{0};
+    for (auto piece : multibase::encode_chunks(pieces, base)) {
+      encoded += piece;
+      ++yields;
+    }
+    EXPECT_THAT(encoded, expected) << magic_enum::enum_name(base);
+    if (multibase::codec{base}.decoded_chunk_size()) {
+      EXPECT_THAT(yields, ::testing::Gt(1)) << magic_enum::enum_name(base);
+    }
+
+    auto decoded = std::vector<std::byte>{};
+    for (auto piece : multibase::decode_chunks(split(expected))) {
+      decoded.insert(decoded.end(), piece.begin(), piece.end());
+    }
+    EXPECT_THAT(decoded, ::testing::ElementsAreArray(bytes))
+        << magic_enum::enum_name(base);
+    decoded.clear();
+    const auto unprefixed = std::string_view{expected}.substr(1);
+    for (auto piece : multibase::decode_chunks(split(unprefixed), base)) {
+      decoded.insert(decoded.end(), piece.begin(), piece.end());
+    }
+    EXPECT_THAT(decoded, ::testing::ElementsAreArray(bytes));
+  });
+  const auto empty = std::vector<std::string>{{}, {}};
+  EXPECT_THROW(std::ranges::for_each(multibase::decode_chunks(empty),
+                                     [](auto /*piece*/) {}),
+               std::invalid_argument);
+  auto invalid = multibase::encode(data, multibase::encoding::base_64);
+  invalid.back() = '!';
+  auto decoded = std::size_t{0};
+  EXPECT_THROW(std::ranges::for_each(
+                   multibase::decode_chunks(split(invalid)),
+                   [&decoded](auto piece) { decoded += piece.size(); }),
+               std::invalid_argument);
+  // pieces before the invalid one have been passed on
+  EXPECT_THAT(decoded, ::testing::Gt(0));
+}
+
+#if MULTIBASE_HAVE_POSIX_IO
+/// Frame of a request to a server, or of a response when operation is its
+/// status, leaving out a code of zero
+std::string frame(char operation, char code, std::string_view payload) {
+  auto body = std::string{operation};
+  if (code != 0) {
+    body += code;
+  }
+  body += payload;
+  auto result = std::string(4, 0);
+  for (auto i = std::size_t{0}; i < result.size(); ++i) {
+    result[result.size() - 1 - i] =
+        static_cast<char>((body.size() >> (8 * i)) & 0xFFU);
+  }
+  return result + body;
+}
+
+std::string frame(multibase::operation operation, char code,
+                  std::string_view payload) {
+  return frame(static_cast<char>(operation), code, payload);
+}
+
+/// Bodies of the frames of a stream, each with its status or operation
+std::vector<std::string> bodies(std::string_view stream) {
+  auto result = std::vector<std::string>{};
+  while (stream.size() >= 4) {
+    auto length = std::size_t{0};
+    for (auto byte : stream.substr(0, 4)) {
+      length = (length << 8U) | static_cast<unsigned char>(byte);
+    }
+    result.emplace_back(stream.substr(4, length));
+    stream.remove_prefix(std::min(4 + length, stream.size()));
+  }
+  return result;
+}
+
+/// Responses of serve to the pieces of input, written from another thread
+std::vector<std::string> serve_pieces(
+    const std::vector<std::string_view>& pieces) {
+  auto requests = std::array<int, 2>{};
+  auto responses = std::array<int, 2>{};
+  if (::pipe(requests.data()) != 0 || ::pipe(responses.data()) != 0) {
+    ADD_FAILURE() << "pipe";
+    return {};
+  }
+  auto writer = std::thread{[&pieces, input = requests[1]] {
+    for (auto piece : pieces) {
+      EXPECT_THAT(::write(input, piece.data(), piece.size()),
+                  static_cast<ssize_t>(piece.size()));
+    }
+    ::close(input);
+  }};
+  auto result = std::string{};
+  auto reader = std::thread{[&result, output = responses[0]] {
+    auto buffer = std::array<char, 4096>{};
+    for (;;) {
+      const auto count = ::read(output, buffer.data(), buffer.size());
+      if (count <= 0) {
+        break;
+      }
+      result.append(buffer.data(), static_cast<std::size_t>(count));
+    }
+  }};
+  multibase::serve(requests[0], responses[1]);
+  ::close(responses[1]);
+  writer.join();
+  reader.join();
+  ::close(requests[0]);
+  ::close(responses[0]);
+  return bodies(result);
+}
+
+TEST(Multibase, Server) {  // NOLINT
+  using enum multibase::operation;
+  using multibase::any_encoding;
+  constexpr auto success = '\0';
+  constexpr auto failure = '\1';
+  const auto requests =
+      frame(encode, 'm', "hello") + frame(decode, any_encoding, "maGVsbG8") +
+      frame(decode, 'm', "maGVsbG8") + frame(transcode, 'f', "maGVsbG8") +
+      frame(validate, any_encoding, "maGVsbG8") +
+      frame(decode, 'z', "maGVsbG8") +
+      frame(validate, 'm', "maGV*bG8") + frame(decode, any_encoding, "ma!") +
+      frame('x', 'm', "hello") + frame(encode, 0, "") +
+      frame(encode, 'm', std::string(10000, 'a'));
+  const auto expected =
+      frame(success, 0, "maGVsbG8") + frame(success, 0, "hello") +
+      frame(success, 0, "hello") + frame(success, 0, "f68656c6c6f") +
+      frame(success, 0, std::string_view{"\0\0\0\0\0\0\0\5", 8}) +
+      frame(failure, 0, "Expected encoding z but found m") +
+      frame(failure, 0, "Invalid input at offset 4") +
+      frame(failure, 0,
+            error_message([] { multibase::decode(std::string{"ma!"}); })) +
+      frame(failure, 0, "Unknown operation x") +
+      frame(failure, 0, "Request without operation or encoding") +
+      frame(success, 0,
+            multibase::encode(std::string(10000, 'a'),
+                              multibase::encoding::base_64));
+  // every request at once, as a client pipelining them sends them
+  EXPECT_THAT(serve_pieces({requests}),
+              ::testing::ElementsAreArray(bodies(expected)));
+  // frames split across reads are answered the same
+  EXPECT_THAT(serve_pieces(split(requests)),
+              ::testing::ElementsAreArray(bodies(expected)));
+  EXPECT_THAT(serve_pieces({}), ::testing::IsEmpty());
+}
+#endif
+
+TEST(Multibase, Instrumentation) {  // NOLINT
+  namespace instrumentation = multibase::instrumentation;
+  using enum instrumentation::operation;
+  if constexpr (!instrumentation::enabled) {
+    GTEST_SKIP() << "built without MULTIBASE_INSTRUMENTATION";
+  }
+  constexpr auto base = multibase::encoding::base_64;
+  const auto before = instrumentation::read();
+  // counters of a thread which has exited are kept
+  std::thread{[] {
+    EXPECT_THAT(multibase::encode(std::string_view{"hello"}, base), "maGVsbG8");
+  }}.join();
+  EXPECT_THAT(multibase::decode(std::string_view{"maGVsbG8"}).size(), 5);
+  EXPECT_THROW(multibase::decode(std::string_view{"ma*"}),  // NOLINT
+               std::invalid_argument);
+  const auto after = instrumentation::read();
+  const auto& encoded = after(base, encode);
+  EXPECT_THAT(encoded.calls - before(base, encode).calls, 1);
+  EXPECT_THAT(encoded.bytes_in - before(base, encode).bytes_in, 5);
+  EXPECT_THAT(encoded.bytes_out - before(base, encode).bytes_out, 7);
+  const auto& decoded = after(base, decode);
+  EXPECT_THAT(decoded.calls - before(base, decode).calls, 2);
+  EXPECT_THAT(decoded.bytes_out - before(base, decode).bytes_out, 5);
+  EXPECT_THAT(decoded.errors - before(base, decode).errors, 1);
+  if constexpr (instrumentation::histogram) {
+    // five bytes fall in the bucket of four to eight
+    EXPECT_THAT(encoded.sizes.at(3) - before(base, encode).sizes.at(3), 1);
+  }
+}
+
 INSTANTIATE_TEST_SUITE_P(  // NOLINT
     multibase, codec,
     ::testing::Values(